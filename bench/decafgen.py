@@ -0,0 +1,297 @@
+"""
+Generates a valid Decaf program of a given size, for measuring how the
+compilers scale. Run:
+
+    python decafgen.py -m 100 -s 50 > big.decaf
+
+The program declares globals and methods with int and bool parameters,
+locals and return values, and every expression is type correct, so it
+passes decafcomp's semantic checks. A method only calls the methods
+before it, and main is the last method.
+
+With --subset expr only the part of Decaf that decafexpr generates code
+for is used: no globals, arrays, if, while or for. Parameters are passed
+but never read, because decafexpr does not look them up by name.
+
+--chain and --nest add one very deep statement to every method, for
+finding the parts of a compiler that recurse on the depth of the AST:
+an assignment of a left associative chain of that many terms, and
+that many nested blocks (if and while too, unless --subset expr).
+They do not use the random numbers, so a seed gives the same program
+with or without them.
+
+The programs are for compiling, not for running: nothing stops a
+generated loop from running for a very long time.
+
+To see all the options, run:
+
+    python decafgen.py -h
+"""
+
+import sys, optparse, random, re
+
+INT, BOOL, VOID = 'int', 'bool', 'void'
+
+class Method:
+
+    def __init__(self, name, params, return_type):
+        self.name = name
+        self.params = params # list of (name, type)
+        self.return_type = return_type
+
+class DecafGen:
+
+    def __init__(self, opts):
+        self.rng = random.Random(opts.seed)
+        self.methods = opts.methods # number of methods, including main
+        self.globals = opts.globals # number of global variables
+        self.statements = opts.statements # statements in each method, counting nested ones
+        self.depth = opts.depth # how deeply statements can nest
+        self.expr_depth = opts.expr_depth # how deeply expressions can nest
+        self.subset = opts.subset # 'comp' for all of Decaf, 'expr' for decafexpr
+        self.chain = opts.chain # terms in the extra chain statement of each method
+        self.nest = opts.nest # nesting of the extra nested statement of each method
+        self.lines = []
+
+    def emit(self, indent, text):
+        self.lines.append('\t' * indent + text)
+
+    # declarations
+
+    def declare_globals(self):
+        self.int_globals, self.bool_globals, self.arrays = [], [], []
+        if self.subset == 'expr':
+            return
+        for i in range(self.globals):
+            if i % 4 == 3:
+                name = "ga{}".format(i)
+                self.arrays.append(name)
+                self.emit(1, "var {} [64]int;".format(name))
+            elif i % 4 == 2:
+                name = "gb{}".format(i)
+                self.bool_globals.append(name)
+                self.emit(1, "var {} bool;".format(name))
+            else:
+                name = "g{}".format(i)
+                self.int_globals.append(name)
+                self.emit(1, "var {} int;".format(name))
+
+    def declare_methods(self):
+        self.signatures = []
+        for i in range(self.methods - 1):
+            params = [("p{}".format(k), self.rng.choice([INT, INT, BOOL])) for k in range(self.rng.randint(0, 3))]
+            return_type = self.rng.choice([INT, INT, BOOL, VOID])
+            self.signatures.append(Method("f{}".format(i), params, return_type))
+        self.signatures.append(Method("main", [], INT))
+
+    # expressions
+
+    def variables(self, decaf_type):
+        if decaf_type == INT:
+            return self.int_vars + self.int_globals
+        return self.bool_vars + self.bool_globals
+
+    def callees(self, decaf_type):
+        return [m for m in self.signatures[:self.current] if m.return_type == decaf_type]
+
+    def call(self, method, depth):
+        args = [self.expr(t, min(depth, 1)) for (_, t) in method.params]
+        return "{}({})".format(method.name, ", ".join(args))
+
+    def leaf(self, decaf_type, depth):
+        callees = self.callees(decaf_type)
+        r = self.rng.random()
+        if callees and r < 0.1:
+            return self.call(self.rng.choice(callees), depth)
+        if r < 0.25:
+            if decaf_type == INT:
+                if self.arrays and r < 0.2:
+                    return "{}[{}]".format(self.rng.choice(self.arrays), self.rng.randrange(64))
+                n = self.rng.randrange(1000)
+                return self.rng.choice([str(n), hex(n), "'{}'".format(chr(self.rng.randint(ord('a'), ord('z'))))])
+            return self.rng.choice(["true", "false"])
+        return self.rng.choice(self.variables(decaf_type))
+
+    def expr(self, decaf_type, depth):
+        if depth <= 0 or self.rng.random() < 0.25:
+            return self.leaf(decaf_type, depth)
+        r = self.rng.random()
+        if decaf_type == INT:
+            if r < 0.1:
+                return "-({})".format(self.expr(INT, depth - 1))
+            op = self.rng.choice(['+', '-', '*', '+', '-', '/', '%', '<<', '>>'])
+            left = self.expr(INT, depth - 1)
+            if op in ('/', '%'):
+                right = str(self.rng.randint(1, 99))
+            elif op in ('<<', '>>'):
+                right = str(self.rng.randint(0, 8))
+            else:
+                right = self.expr(INT, depth - 1)
+            return "({} {} {})".format(left, op, right)
+        if r < 0.1:
+            return "!({})".format(self.expr(BOOL, depth - 1))
+        if r < 0.55:
+            op = self.rng.choice(['<', '>', '<=', '>=', '==', '!='])
+            return "({} {} {})".format(self.expr(INT, depth - 1), op, self.expr(INT, depth - 1))
+        op = self.rng.choice(['&&', '||', '==', '!='])
+        return "({} {} {})".format(self.expr(BOOL, depth - 1), op, self.expr(BOOL, depth - 1))
+
+    # statements
+
+    def simple_statement(self, indent):
+        r = self.rng.random()
+        callees = [m for m in self.signatures[:self.current]]
+        if r < 0.15 and callees:
+            self.emit(indent, self.call(self.rng.choice(callees), self.expr_depth) + ";")
+        elif r < 0.25:
+            if self.rng.random() < 0.5:
+                self.emit(indent, "print_int({});".format(self.expr(INT, self.expr_depth)))
+            else:
+                self.emit(indent, 'print_string("{} {}\\n");'.format(self.current, len(self.lines)))
+        elif r < 0.4:
+            self.emit(indent, "{} = {};".format(self.rng.choice(self.variables(BOOL)), self.expr(BOOL, self.expr_depth)))
+        elif self.arrays and r < 0.5:
+            self.emit(indent, "{}[{}] = {};".format(self.rng.choice(self.arrays), self.expr(INT, 1), self.expr(INT, self.expr_depth)))
+        else:
+            self.emit(indent, "{} = {};".format(self.rng.choice(self.variables(INT)), self.expr(INT, self.expr_depth)))
+
+    def statement_list(self, n, indent, depth, in_loop):
+        """
+        Emits n statements, counting the statements nested in them and
+        counting each if, while, for and block as one.
+        """
+        while n > 0:
+            kinds = ['block'] if self.subset == 'expr' else ['block', 'if', 'if', 'while', 'for']
+            if depth >= self.depth or n < 2 or self.rng.random() < 0.6:
+                if in_loop and self.subset != 'expr' and self.rng.random() < 0.05:
+                    self.emit(indent, "if ({}) {{".format(self.expr(BOOL, 1)))
+                    self.emit(indent + 1, self.rng.choice(["break;", "continue;"]))
+                    self.emit(indent, "}")
+                else:
+                    self.simple_statement(indent)
+                n -= 1
+                continue
+            inner = self.rng.randint(1, max(1, (n - 1) // 2))
+            n -= inner + 1
+            kind = self.rng.choice(kinds)
+            if kind == 'block':
+                self.emit(indent, "{")
+                self.statement_list(inner, indent + 1, depth + 1, in_loop)
+            elif kind == 'if':
+                self.emit(indent, "if ({}) {{".format(self.expr(BOOL, self.expr_depth)))
+                if inner >= 2 and self.rng.random() < 0.5:
+                    self.statement_list(inner // 2, indent + 1, depth + 1, in_loop)
+                    self.emit(indent, "} else {")
+                    self.statement_list(inner - inner // 2, indent + 1, depth + 1, in_loop)
+                else:
+                    self.statement_list(inner, indent + 1, depth + 1, in_loop)
+            elif kind == 'while':
+                self.emit(indent, "while ({}) {{".format(self.expr(BOOL, self.expr_depth)))
+                self.statement_list(inner, indent + 1, depth + 1, True)
+            else:
+                i = self.rng.choice(self.int_vars)
+                self.emit(indent, "for ({0} = 0; {0} < {1}; {0} = {0} + 1) {{".format(i, self.rng.randint(1, 100)))
+                self.statement_list(inner, indent + 1, depth + 1, True)
+            self.emit(indent, "}")
+
+    def chain_statement(self, indent):
+        terms = []
+        for k in range(self.chain):
+            terms.append(self.int_vars[k % len(self.int_vars)] if k % 2 == 0 else str(k % 1000))
+        ops = ['+', '-', '*', '+']
+        text = terms[0]
+        for k in range(1, self.chain):
+            text += " {} {}".format(ops[k % len(ops)], terms[k])
+        self.emit(indent, "{} = {};".format(self.int_vars[0], text))
+
+    def nested_statement(self, indent):
+        kinds = ['{', '{'] if self.subset == 'expr' else ['{', 'if (b0) {', 'while (b1) {']
+        # on three lines, indenting each level would make the program grow as nest^2
+        self.emit(indent, " ".join(kinds[k % len(kinds)] for k in range(self.nest)))
+        self.emit(indent + 1, "{0} = {0} + 1;".format(self.int_vars[0]))
+        self.emit(indent, "}" * self.nest)
+
+    def method(self, index):
+        self.current = index
+        m = self.signatures[index]
+        params = ", ".join("{} {}".format(name, t) for (name, t) in m.params)
+        self.emit(1, "func {}({}) {} {{".format(m.name, params, m.return_type))
+        self.emit(2, "var i0, i1, i2 int;")
+        self.emit(2, "var b0, b1 bool;")
+        self.int_vars = ["i0", "i1", "i2"]
+        self.bool_vars = ["b0", "b1"]
+        if self.subset != 'expr':
+            self.int_vars += [name for (name, t) in m.params if t == INT]
+            self.bool_vars += [name for (name, t) in m.params if t == BOOL]
+        self.statement_list(self.statements, 2, 0, False)
+        if self.chain > 0:
+            self.chain_statement(2)
+        if self.nest > 0:
+            self.nested_statement(2)
+        if m.name == 'main':
+            self.emit(2, "return(0);")
+        elif m.return_type != VOID:
+            self.emit(2, "return({});".format(self.expr(m.return_type, self.expr_depth)))
+        self.emit(1, "}")
+
+    def program(self, comment):
+        self.emit(0, "// {}".format(comment))
+        self.emit(0, "extern func print_int(int) void;")
+        self.emit(0, "extern func print_string(string) void;")
+        self.emit(0, "package Bench {")
+        self.declare_globals()
+        self.declare_methods()
+        for i in range(self.methods):
+            self.method(i)
+        self.emit(0, "}")
+        return "\n".join(self.lines) + "\n"
+
+token_re = re.compile(r'''
+      //[^\n]*                      # comment
+    | \s+                           # whitespace
+    | "(?:[^"\\\n]|\\.)*"           # string constant
+    | '(?:[^'\\\n]|\\.)'            # char constant
+    | [A-Za-z_][A-Za-z0-9_]*        # identifier or keyword
+    | 0[xX][0-9a-fA-F]+ | [0-9]+    # int constant
+    | == | != | <= | >= | << | >> | && | \|\|
+    | .
+''', re.VERBOSE)
+
+def count_tokens(source):
+    "Number of tokens in a Decaf program, not counting whitespace and comments."
+    return sum(1 for t in token_re.findall(source) if not t.isspace() and not t.startswith('//'))
+
+def add_options(optparser):
+    optparser.add_option("-m", "--methods", dest="methods", type="int", default=10, help="number of methods, including main [default: 10]")
+    optparser.add_option("-g", "--globals", dest="globals", type="int", default=8, help="number of global variables, every fourth an array [default: 8]")
+    optparser.add_option("-s", "--statements", dest="statements", type="int", default=20, help="statements in each method, counting nested ones [default: 20]")
+    optparser.add_option("-d", "--depth", dest="depth", type="int", default=3, help="how deeply blocks, if, while and for can nest [default: 3]")
+    optparser.add_option("-e", "--expr-depth", dest="expr_depth", type="int", default=3, help="how deeply expressions can nest [default: 3]")
+    optparser.add_option("--chain", dest="chain", type="int", default=0, help="add to each method an assignment of a chain of this many terms [default: 0]")
+    optparser.add_option("--nest", dest="nest", type="int", default=0, help="add to each method a statement nested this many blocks deep [default: 0]")
+    optparser.add_option("--subset", dest="subset", type="choice", choices=['comp', 'expr'], default='comp', help="'expr' to only use what decafexpr generates code for [default: comp]")
+    optparser.add_option("--seed", dest="seed", type="int", default=379, help="random seed, the same seed gives the same program [default: 379]")
+
+def generate(opts):
+    comment = "decafgen.py -m {} -g {} -s {} -d {} -e {} --subset {} --seed {}".format(
+        opts.methods, opts.globals, opts.statements, opts.depth, opts.expr_depth, opts.subset, opts.seed)
+    if opts.chain > 0:
+        comment += " --chain {}".format(opts.chain)
+    if opts.nest > 0:
+        comment += " --nest {}".format(opts.nest)
+    return DecafGen(opts).program(comment)
+
+if __name__ == '__main__':
+    optparser = optparse.OptionParser()
+    add_options(optparser)
+    optparser.add_option("-o", "--output", dest="output", default=None, help="write the program to this file [default: stdout]")
+    (opts, _) = optparser.parse_args()
+    if opts.methods < 1:
+        optparser.error("there has to be at least one method, main")
+
+    source = generate(opts)
+    if opts.output is None:
+        sys.stdout.write(source)
+    else:
+        with open(opts.output, 'w') as output:
+            output.write(source)
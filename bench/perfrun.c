@@ -0,0 +1,115 @@
+/*
+ * perfrun - runs a program and writes its wall time and hardware
+ * counters to a file, for runtime.py:
+ *
+ *   perfrun -o counts.txt program [args...]
+ *
+ * The program gets perfrun's stdin, stdout and stderr, and perfrun
+ * exits with its exit status. The file has one "name value" line for
+ * seconds, cycles, instructions, cache-misses and branch-misses.
+ *
+ * The counters are opened with perf_event_open on the child after the
+ * fork and before the exec, as perf stat does, and only count once the
+ * exec is done. They count user space only, which perf_event_paranoid
+ * 2 allows. A counter that cannot be opened, e.g. in a virtual machine
+ * without a PMU, is written as "-".
+ */
+
+#define _GNU_SOURCE
+#include <linux/perf_event.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+static const struct {
+    const char *name;
+    uint64_t config;
+} counters[] = {
+    { "cycles", PERF_COUNT_HW_CPU_CYCLES },
+    { "instructions", PERF_COUNT_HW_INSTRUCTIONS },
+    { "cache-misses", PERF_COUNT_HW_CACHE_MISSES },
+    { "branch-misses", PERF_COUNT_HW_BRANCH_MISSES },
+};
+
+#define NCOUNTERS (sizeof(counters) / sizeof(counters[0]))
+
+static int open_counter(pid_t pid, uint64_t config) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.enable_on_exec = 1;
+    attr.inherit = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return syscall(SYS_perf_event_open, &attr, pid, -1, -1, 0);
+}
+
+static double now(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 4 || strcmp(argv[1], "-o") != 0) {
+        fputs("usage: perfrun -o counts.txt program [args...]\n", stderr);
+        exit(EXIT_FAILURE);
+    }
+    FILE *out = fopen(argv[2], "w");
+    if (out == NULL) {
+        perror(argv[2]);
+        exit(EXIT_FAILURE);
+    }
+
+    /* the child waits on this pipe until its counters are open */
+    int go[2];
+    if (pipe(go) != 0) {
+        perror("pipe");
+        exit(EXIT_FAILURE);
+    }
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("fork");
+        exit(EXIT_FAILURE);
+    }
+    if (pid == 0) {
+        char c;
+        close(go[1]);
+        while (read(go[0], &c, 1) > 0) {
+        }
+        close(go[0]);
+        execvp(argv[3], argv + 3);
+        perror(argv[3]);
+        _exit(127);
+    }
+    close(go[0]);
+    int fds[NCOUNTERS];
+    for (size_t i = 0; i < NCOUNTERS; i++) {
+        fds[i] = open_counter(pid, counters[i].config);
+    }
+    double start = now();
+    close(go[1]);
+    int status;
+    waitpid(pid, &status, 0);
+    double seconds = now() - start;
+
+    fprintf(out, "seconds %.6f\n", seconds);
+    for (size_t i = 0; i < NCOUNTERS; i++) {
+        uint64_t value;
+        if (fds[i] >= 0 && read(fds[i], &value, sizeof(value)) == sizeof(value)) {
+            fprintf(out, "%s %llu\n", counters[i].name, (unsigned long long)value);
+        } else {
+            fprintf(out, "%s -\n", counters[i].name);
+        }
+    }
+    fclose(out);
+    exit(WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status));
+}
@@ -0,0 +1,32 @@
+/* catalan.decaf in C */
+
+void print_int(int);
+void print_string(const char *);
+int read_int(void);
+
+int fact(int n) {
+    if (n <= 1) { return 1; }
+    return n * fact(n - 1);
+}
+
+int choose(int a, int b) {
+    return fact(a) / (fact(b) * fact(a - b));
+}
+
+int cat(int n) {
+    return choose(2 * n, n) / (n + 1);
+}
+
+int main(void) {
+    int rounds, r, n, sum;
+    rounds = read_int();
+    sum = 0;
+    for (r = 0; r < rounds; r = r + 1) {
+        for (n = 1; n <= 6; n = n + 1) {
+            sum = (sum + cat(n)) % 1000000;
+        }
+    }
+    print_int(sum);
+    print_string("\n");
+    return 0;
+}
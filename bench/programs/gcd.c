@@ -0,0 +1,29 @@
+/* gcd.decaf in C */
+
+void print_int(int);
+void print_string(const char *);
+int read_int(void);
+
+int gcd(int a, int b) {
+    int t;
+    while (b != 0) {
+        t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+int main(void) {
+    int n, i, j, sum;
+    n = read_int();
+    sum = 0;
+    for (i = 1; i <= n; i = i + 1) {
+        for (j = 1; j <= n; j = j + 1) {
+            sum = sum + gcd(i, j);
+        }
+    }
+    print_int(sum);
+    print_string("\n");
+    return 0;
+}
@@ -0,0 +1,48 @@
+/* matmul.decaf in C */
+
+void print_int(int);
+void print_string(const char *);
+int read_int(void);
+
+int a[40000];
+int b[40000];
+int c[40000];
+int n;
+int i, j, k;
+int sum;
+
+void init(void) {
+    for (i = 0; i < n * n; i = i + 1) {
+        a[i] = (i * 7) % 10;
+        b[i] = (i * 3 + 1) % 10;
+    }
+}
+
+void multiply(void) {
+    for (i = 0; i < n; i = i + 1) {
+        for (j = 0; j < n; j = j + 1) {
+            sum = 0;
+            for (k = 0; k < n; k = k + 1) {
+                sum = sum + a[i * n + k] * b[k * n + j];
+            }
+            c[i * n + j] = sum;
+        }
+    }
+}
+
+int main(void) {
+    int rounds, r, trace;
+    n = read_int();
+    rounds = read_int();
+    init();
+    for (r = 0; r < rounds; r = r + 1) {
+        multiply();
+    }
+    trace = 0;
+    for (i = 0; i < n; i = i + 1) {
+        trace = trace + c[i * n + i];
+    }
+    print_int(trace);
+    print_string("\n");
+    return 0;
+}
@@ -0,0 +1,64 @@
+/* quicksort.decaf in C */
+
+void print_int(int);
+void print_string(const char *);
+int read_int(void);
+
+int list[500000];
+int seed;
+
+int random_int(void) {
+    seed = (seed * 75 + 74) % 65537;
+    return seed;
+}
+
+void swap(int i, int j) {
+    int t;
+    t = list[i];
+    list[i] = list[j];
+    list[j] = t;
+}
+
+int partition(int lo, int hi) {
+    int pivot, i, j;
+    pivot = list[hi];
+    i = lo;
+    for (j = lo; j < hi; j = j + 1) {
+        if (list[j] < pivot) {
+            swap(i, j);
+            i = i + 1;
+        }
+    }
+    swap(i, hi);
+    return i;
+}
+
+void quicksort(int lo, int hi) {
+    int p;
+    if (lo < hi) {
+        p = partition(lo, hi);
+        quicksort(lo, p - 1);
+        quicksort(p + 1, hi);
+    }
+}
+
+int main(void) {
+    int n, i, check;
+    n = read_int();
+    seed = read_int();
+    for (i = 0; i < n; i = i + 1) {
+        list[i] = random_int();
+    }
+    quicksort(0, n - 1);
+    check = 0;
+    for (i = 1; i < n; i = i + 1) {
+        if (list[i - 1] > list[i]) {
+            check = check + 1;
+        }
+    }
+    print_int(check);
+    print_string(" ");
+    print_int(list[n / 2]);
+    print_string("\n");
+    return 0;
+}
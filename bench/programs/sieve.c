@@ -0,0 +1,37 @@
+/* sieve.decaf in C */
+
+void print_int(int);
+void print_string(const char *);
+int read_int(void);
+
+int composite[1000000];
+
+int sieve(int n) {
+    int i, j, count;
+    for (i = 0; i < n; i = i + 1) {
+        composite[i] = 0;
+    }
+    count = 0;
+    for (i = 2; i < n; i = i + 1) {
+        if (composite[i] == 0) {
+            count = count + 1;
+            j = i + i;
+            while (j < n) {
+                composite[j] = 1;
+                j = j + i;
+            }
+        }
+    }
+    return count;
+}
+
+int main(void) {
+    int rounds, r, count = 0;
+    rounds = read_int();
+    for (r = 0; r < rounds; r = r + 1) {
+        count = sieve(1000000);
+    }
+    print_int(count);
+    print_string("\n");
+    return 0;
+}
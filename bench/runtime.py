@@ -0,0 +1,192 @@
+"""
+Measures how fast the programs that decafcomp generates run. First
+build decafcomp in ../decafcomp/answer, then run:
+
+    python runtime.py
+
+Every program in programs/ is compiled the way llvm-run does it
+(decafcomp, llvm-as, llc and cc with the Decaf standard library) with
+each of the settings below, run --repeat times with its .in file on
+stdin, and the median of the runs is reported. When there is a .c file
+with the same program in C it is compiled with cc -O0 and -O2 and run
+the same way, and the last column is the time relative to cc -O2.
+
+The runs go through perfrun.c, which also reads the cycles,
+instructions, cache misses and branch misses of each run with
+perf_event_open. Counters the machine does not have are shown as -.
+
+A setting whose output differs from that of the first setting fails,
+and then runtime.py exits with status 1.
+
+The tools can be changed like in llvm-run: LLVMAS, LLC and CC in the
+environment, or see:
+
+    python runtime.py -h
+"""
+
+import sys, os, optparse, tempfile, subprocess, shutil, statistics
+
+bench_dir = os.path.dirname(os.path.abspath(__file__))
+
+# name, decafcomp options, llc options
+settings = [
+    ('decafcomp', [], ['-O0']),
+    ('decafcomp llc -O2', [], ['-O2']),
+    ('decafcomp -O', ['-O'], ['-O0']),
+    ('decafcomp -O llc -O2', ['-O'], ['-O2']),
+]
+
+# name, cc options
+c_settings = [
+    ('cc -O0', ['-O0']),
+    ('cc -O2', ['-O2']),
+]
+
+counter_names = ['cycles', 'instructions', 'cache-misses', 'branch-misses']
+
+class Runtime:
+
+    def __init__(self, opts):
+        self.decafcomp = opts.decafcomp # compiler under test
+        self.stdlib = opts.stdlib # linked into every program
+        self.program_dir = opts.program_dir # the .decaf programs with their .in and .c files
+        self.repeat = opts.repeat # runs of each executable
+        self.compare_c = opts.compare_c # also build and run the .c programs
+        self.only = opts.only.split(',') if opts.only else None
+        self.csv_file = opts.csv_file # also write the medians here
+        bindir = subprocess.check_output([opts.llvm_config, "--bindir"]).strip().decode('utf-8')
+        self.llvmas = os.environ.get('LLVMAS') or os.path.join(bindir, 'llvm-as')
+        self.llc = os.environ.get('LLC') or os.path.join(bindir, 'llc')
+        self.cc = os.environ.get('CC') or 'clang'
+        self.work_dir = tempfile.mkdtemp(prefix='decaf-runtime')
+
+    def command(self, argv, stdout=None):
+        "Runs argv and returns True if it succeeded, printing its stderr if not."
+        prog = subprocess.run(argv, stdout=stdout, stderr=subprocess.PIPE)
+        if prog.returncode != 0:
+            print("failed: {}".format(" ".join(argv)), file=sys.stderr)
+            sys.stderr.write(prog.stderr.decode('utf-8', 'replace')[-2000:])
+        return prog.returncode == 0
+
+    def build_decaf(self, source, name, decafcomp_opts, llc_opts):
+        prefix = os.path.join(self.work_dir, name)
+        # decafcomp writes the module to stderr
+        with open(prefix + '.ll', 'w') as ll:
+            prog = subprocess.run([self.decafcomp] + decafcomp_opts + [source], stdout=subprocess.DEVNULL, stderr=ll)
+        if prog.returncode != 0:
+            print("failed: {} {}".format(self.decafcomp, source), file=sys.stderr)
+            return None
+        if (self.command([self.llvmas, prefix + '.ll', '-o', prefix + '.bc'])
+                and self.command([self.llc] + llc_opts + ['-relocation-model=pic', prefix + '.bc', '-o', prefix + '.s'])
+                and self.command([self.cc, '-o', prefix + '.exec', prefix + '.s', self.stdlib])):
+            return prefix + '.exec'
+        return None
+
+    def build_c(self, source, name, cc_opts):
+        prefix = os.path.join(self.work_dir, name)
+        if self.command([self.cc] + cc_opts + ['-o', prefix + '.exec', source, self.stdlib]):
+            return prefix + '.exec'
+        return None
+
+    def run(self, executable, input_path):
+        """
+        Runs executable self.repeat times and returns its output, the
+        median time and the median of each counter (None if there is no
+        such counter).
+        """
+        counts_path = os.path.join(self.work_dir, 'counts.txt')
+        output_path = os.path.join(self.work_dir, 'output.txt')
+        samples = {name: [] for name in ['seconds'] + counter_names}
+        for _ in range(self.repeat):
+            with open(input_path if input_path else os.devnull) as stdin_file, open(output_path, 'w') as stdout_file:
+                subprocess.run([self.perfrun, '-o', counts_path, executable], stdin=stdin_file, stdout=stdout_file)
+            with open(counts_path) as counts:
+                for line in counts:
+                    (name, value) = line.split()
+                    if value != '-':
+                        samples[name].append(float(value))
+        with open(output_path) as f:
+            output = f.read()
+        medians = {name: statistics.median(values) if len(values) == self.repeat else None for (name, values) in samples.items()}
+        return output, medians
+
+    def report(self, program, results, csv):
+        print(program)
+        print("{:<22} {:>9} {:>14} {:>14} {:>6} {:>12} {:>13} {:>7}".format(
+            'setting', 'seconds', 'cycles', 'instructions', 'IPC', 'cache-misses', 'branch-misses', 'vs C'))
+        baseline = dict(results).get('cc -O2')
+        for (setting, m) in results:
+            if m is None:
+                print("{:<22} {}".format(setting, 'FAILED'))
+                continue
+            count = lambda name, width: "{:>{}}".format('-' if m[name] is None else "{:.0f}".format(m[name]), width)
+            ipc = "{:6.2f}".format(m['instructions'] / m['cycles']) if m['cycles'] and m['instructions'] is not None else "{:>6}".format('-')
+            vs_c = "{:6.2f}x".format(m['seconds'] / baseline['seconds']) if baseline and baseline['seconds'] > 0 else "{:>7}".format('-')
+            print("{:<22} {:9.4f} {} {} {} {} {} {}{}".format(
+                setting, m['seconds'], count('cycles', 14), count('instructions', 14), ipc,
+                count('cache-misses', 12), count('branch-misses', 13), vs_c,
+                "" if m['output ok'] else "  WRONG OUTPUT"))
+            if csv is not None:
+                values = [program, setting, "{:.6f}".format(m['seconds'])] + ['' if m[name] is None else "{:.0f}".format(m[name]) for name in counter_names]
+                print(",".join(values + [str(int(m['output ok']))]), file=csv)
+        print()
+
+    def run_all(self):
+        if not (os.path.isfile(self.decafcomp) and os.access(self.decafcomp, os.X_OK)):
+            print("executable missing: {}".format(self.decafcomp), file=sys.stderr)
+            sys.exit(1)
+        self.perfrun = os.path.join(self.work_dir, 'perfrun')
+        if not self.command([self.cc, '-O2', '-o', self.perfrun, os.path.join(bench_dir, 'perfrun.c')]):
+            sys.exit(1)
+
+        csv = None
+        if self.csv_file is not None:
+            csv = open(self.csv_file, 'w')
+            print("program,setting,seconds," + ",".join(counter_names) + ",output_ok", file=csv)
+        ok = True
+        programs = sorted(f[:-len('.decaf')] for f in os.listdir(self.program_dir) if f.endswith('.decaf'))
+        for program in programs:
+            if self.only is not None and program not in self.only:
+                continue
+            source = os.path.join(self.program_dir, program + '.decaf')
+            input_path = os.path.join(self.program_dir, program + '.in')
+            if not os.path.exists(input_path):
+                input_path = None
+            builds = [(setting, self.build_decaf(source, "{}-{}".format(program, i), d_opts, l_opts))
+                      for (i, (setting, d_opts, l_opts)) in enumerate(settings)]
+            c_source = os.path.join(self.program_dir, program + '.c')
+            if self.compare_c and os.path.exists(c_source):
+                builds += [(setting, self.build_c(c_source, "{}-c{}".format(program, i), cc_opts))
+                           for (i, (setting, cc_opts)) in enumerate(c_settings)]
+            results, expected = [], None
+            for (setting, executable) in builds:
+                if executable is None:
+                    results.append((setting, None))
+                    ok = False
+                    continue
+                (output, m) = self.run(executable, input_path)
+                if expected is None:
+                    expected = output
+                m['output ok'] = output == expected
+                ok = ok and m['output ok']
+                results.append((setting, m))
+            self.report(program, results, csv)
+        if csv is not None:
+            csv.close()
+        shutil.rmtree(self.work_dir)
+        return ok
+
+if __name__ == '__main__':
+    optparser = optparse.OptionParser()
+    optparser.add_option("-c", "--decafcomp", dest="decafcomp", default=os.path.join(bench_dir, '..', 'decafcomp', 'answer', 'decafcomp'), help="compiler to measure [default: ../decafcomp/answer/decafcomp]")
+    optparser.add_option("-s", "--stdlib", dest="stdlib", default=os.path.join(bench_dir, '..', 'decafcomp', 'answer', 'decaf-stdlib.c'), help="standard library to link with [default: ../decafcomp/answer/decaf-stdlib.c]")
+    optparser.add_option("-p", "--programs", dest="program_dir", default=os.path.join(bench_dir, 'programs'), help="directory with the programs [default: programs]")
+    optparser.add_option("--only", dest="only", default=None, help="only run these programs, separated by commas")
+    optparser.add_option("-n", "--repeat", dest="repeat", type="int", default=5, help="run each executable this many times [default: 5]")
+    optparser.add_option("--no-c", dest="compare_c", action="store_false", default=True, help="do not build and run the C programs")
+    optparser.add_option("--llvm-config", dest="llvm_config", default='llvm-config', help="find llvm-as and llc with this llvm-config [default: llvm-config]")
+    optparser.add_option("--csv", dest="csv_file", default=None, help="also write the medians to this CSV file")
+    (opts, _) = optparser.parse_args()
+
+    if not Runtime(opts).run_all():
+        sys.exit(1)
@@ -0,0 +1,208 @@
+"""
+Measures how decaflex, decafast, decafexpr and decafcomp scale with the
+size of their input. First build each of them in its answer directory,
+then run:
+
+    python scaling.py
+
+For each size a program is generated with decafgen.py, the number of
+methods and globals growing with the size, and every compiler is run
+on it. With --grow chain or --grow nest the size multiplies --chain or
+--nest instead, which finds the compilers that recurse on the depth of
+the AST. The table for each compiler has the lines and tokens per second,
+the peak resident set size and the size of the output, which is the
+LLVM assembly for decafexpr and decafcomp.
+
+How the time grows with the number of tokens is fitted as tokens^k over
+the sizes that took long enough to measure. A compiler is flagged as
+superlinear when k is above --threshold, and then scaling.py exits with
+status 1, as it does when a compiler fails on a generated program.
+
+To see all the options, run:
+
+    python scaling.py -h
+"""
+
+import sys, os, optparse, tempfile, subprocess, threading, time, math, copy
+import decafgen
+
+bench_dir = os.path.dirname(os.path.abspath(__file__))
+
+# the program decafexpr gets only uses what decafexpr generates code for
+compilers = [
+    ('decaflex', 'comp'),
+    ('decafast', 'comp'),
+    ('decafexpr', 'expr'),
+    ('decafcomp', 'comp'),
+]
+
+class Measurement:
+
+    def __init__(self, size, methods, lines, tokens):
+        self.size = size
+        self.methods = methods
+        self.lines = lines
+        self.tokens = tokens
+        self.seconds = None # fastest of the repeated runs
+        self.peak_kb = 0    # largest peak RSS of the repeated runs
+        self.output_bytes = 0
+        self.status = 0
+
+class Scaling:
+
+    def __init__(self, opts):
+        self.opts = opts
+        self.sizes = [int(s) for s in opts.sizes.split(',')]
+        self.repeat = opts.repeat # runs of each compiler on each program
+        self.threshold = opts.threshold # largest exponent that is not flagged
+        self.min_seconds = opts.min_seconds # shorter runs are too noisy to fit
+        self.timeout = opts.timeout
+        self.grow = opts.grow # the decafgen option that the size multiplies
+        self.programs = {}
+        for name in opts.programs.split(','):
+            self.programs[name] = os.path.join(opts.decaf_dir, name, 'answer', name)
+        for binding in opts.binaries:
+            (name, _, path) = binding.partition('=')
+            self.programs[name] = path
+
+    def generate(self, size, subset, program_dir):
+        gen_opts = copy.copy(self.opts)
+        if self.grow == 'methods':
+            gen_opts.methods = self.opts.methods * size
+            gen_opts.globals = self.opts.globals * size
+        else:
+            setattr(gen_opts, self.grow, getattr(self.opts, self.grow) * size)
+        gen_opts.subset = subset
+        source = decafgen.generate(gen_opts)
+        path = os.path.join(program_dir, "size{}-{}.decaf".format(size, subset))
+        with open(path, 'w') as f:
+            f.write(source)
+        return path, Measurement(size, gen_opts.methods, source.count('\n'), decafgen.count_tokens(source))
+
+    def run(self, program, source_path, m):
+        """
+        Runs program with the source on stdin, like zipout.py does, and
+        updates m. The output goes to a file, not a pipe that would have
+        to be read while the program runs.
+        """
+        with open(source_path) as stdin_file, tempfile.TemporaryFile() as out:
+            start = time.monotonic()
+            prog = subprocess.Popen([program], stdin=stdin_file, stdout=out, stderr=out)
+            timer = threading.Timer(self.timeout, prog.kill)
+            timer.start()
+            # wait4 rather than wait to get the peak RSS of this child
+            (_, status, usage) = os.wait4(prog.pid, 0)
+            seconds = time.monotonic() - start
+            timer.cancel()
+            prog.returncode = os.waitstatus_to_exitcode(status)
+            out.seek(0, os.SEEK_END)
+            output_bytes = out.tell()
+        if m.seconds is None or seconds < m.seconds:
+            m.seconds = seconds
+        m.peak_kb = max(m.peak_kb, usage.ru_maxrss)
+        m.output_bytes = output_bytes
+        m.status = m.status or prog.returncode
+
+    def exponent(self, results):
+        """
+        Least squares fit of log(seconds) against log(tokens), and the
+        largest exponent between two neighbouring sizes.
+        """
+        points = [(math.log(m.tokens), math.log(m.seconds)) for m in results if m.seconds >= self.min_seconds]
+        if len(points) < 3:
+            return None, None
+        n = len(points)
+        mx = sum(x for (x, _) in points) / n
+        my = sum(y for (_, y) in points) / n
+        k = sum((x - mx) * (y - my) for (x, y) in points) / sum((x - mx) ** 2 for (x, _) in points)
+        steps = [(y2 - y1) / (x2 - x1) for ((x1, y1), (x2, y2)) in zip(points, points[1:]) if x2 > x1]
+        return k, max(steps)
+
+    def report(self, name, results, csv):
+        print(name)
+        print("{:>6} {:>8} {:>9} {:>9} {:>9} {:>11} {:>11} {:>9} {:>10}".format(
+            'size', 'methods', 'lines', 'tokens', 'seconds', 'lines/s', 'tokens/s', 'peak MB', 'output KB'))
+        for m in results:
+            rate = lambda count: "{:11.0f}".format(count / m.seconds) if m.seconds > 0 else "{:>11}".format('-')
+            print("{:6d} {:8d} {:9d} {:9d} {:9.3f} {} {} {:9.1f} {:10.1f}{}".format(
+                m.size, m.methods, m.lines, m.tokens, m.seconds, rate(m.lines), rate(m.tokens),
+                m.peak_kb / 1024.0, m.output_bytes / 1024.0, "" if m.status == 0 else "  exit {}".format(m.status)))
+            if csv is not None:
+                print(",".join(str(v) for v in (name, m.size, m.methods, m.lines, m.tokens, "{:.6f}".format(m.seconds), m.peak_kb, m.output_bytes, m.status)), file=csv)
+        (k, worst) = self.exponent(results)
+        if k is None:
+            print("too fast to fit, use larger --sizes")
+            print()
+            return False
+        superlinear = k > self.threshold
+        print("time grows as tokens^{:.2f} (between two sizes at most ^{:.2f}){}".format(k, worst, "  SUPERLINEAR" if superlinear else ""))
+        print()
+        return superlinear
+
+    def run_all(self):
+        missing = [path for path in self.programs.values() if not (os.path.isfile(path) and os.access(path, os.X_OK))]
+        if missing:
+            for path in missing:
+                print("executable missing: {}".format(path), file=sys.stderr)
+            sys.exit(1)
+
+        program_dir = self.opts.keep or tempfile.mkdtemp(prefix='decaf-scaling')
+        if self.opts.keep:
+            os.makedirs(program_dir, exist_ok=True)
+        sources = {}
+        for size in self.sizes:
+            for subset in ('comp', 'expr'):
+                sources[(size, subset)] = self.generate(size, subset, program_dir)
+
+        csv = None
+        if self.opts.csv_file is not None:
+            csv = open(self.opts.csv_file, 'w')
+            print("program,size,methods,lines,tokens,seconds,peak_kb,output_bytes,status", file=csv)
+        flagged, failed = [], []
+        for (name, subset) in compilers:
+            if name not in self.programs:
+                continue
+            results = []
+            for size in self.sizes:
+                (path, template) = sources[(size, subset)]
+                m = copy.copy(template)
+                for _ in range(self.repeat):
+                    self.run(self.programs[name], path, m)
+                results.append(m)
+                if m.status != 0:
+                    failed.append("{} on {}".format(name, path))
+            if self.report(name, results, csv):
+                flagged.append(name)
+        if csv is not None:
+            csv.close()
+        if not self.opts.keep:
+            for (path, _) in sources.values():
+                os.remove(path)
+            os.rmdir(program_dir)
+
+        for f in failed:
+            print("failed: {}".format(f), file=sys.stderr)
+        if flagged:
+            print("superlinear: {}".format(", ".join(flagged)), file=sys.stderr)
+        return not failed and not flagged
+
+if __name__ == '__main__':
+    optparser = optparse.OptionParser()
+    optparser.add_option("-p", "--programs", dest="programs", default='decaflex,decafast,decafexpr,decafcomp', help="compilers to measure [default: decaflex,decafast,decafexpr,decafcomp]")
+    optparser.add_option("-b", "--binary", dest="binaries", action="append", default=[], help="NAME=PATH runs PATH as compiler NAME instead of NAME/answer/NAME, can be repeated")
+    optparser.add_option("--decafdir", dest="decaf_dir", default=os.path.dirname(bench_dir), help="directory with the decaflex, decafast, ... directories [default: ..]")
+    optparser.add_option("-z", "--sizes", dest="sizes", default='1,2,4,8,16,32', help="sizes to generate, each one multiplies what --grow says [default: 1,2,4,8,16,32]")
+    optparser.add_option("--grow", dest="grow", type="choice", choices=['methods', 'chain', 'nest'], default='methods', help="what the sizes multiply: 'methods' for --methods and --globals, 'chain' for --chain, 'nest' for --nest [default: methods]")
+    optparser.add_option("-n", "--repeat", dest="repeat", type="int", default=3, help="run each compiler this many times on each program and keep the fastest run [default: 3]")
+    optparser.add_option("--threshold", dest="threshold", type="float", default=1.25, help="flag a compiler whose time grows faster than tokens to this power [default: 1.25]")
+    optparser.add_option("--min-seconds", dest="min_seconds", type="float", default=0.01, help="leave out of the fit the runs faster than this [default: 0.01]")
+    optparser.add_option("--timeout", dest="timeout", type="float", default=300, help="kill a compiler that runs longer than this many seconds [default: 300]")
+    optparser.add_option("--keep", dest="keep", default=None, help="keep the generated programs in this directory")
+    optparser.add_option("--csv", dest="csv_file", default=None, help="also write the measurements to this CSV file")
+    decafgen.add_options(optparser)
+    (opts, _) = optparser.parse_args()
+    if opts.grow != 'methods' and getattr(opts, opts.grow) < 1:
+        optparser.error("--grow {0} needs --{0}".format(opts.grow))
+
+    if not Scaling(opts).run_all():
+        sys.exit(1)
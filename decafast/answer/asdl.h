@@ -0,0 +1,278 @@
+
+#ifndef _DECAF_ASDL_TREE
+#define _DECAF_ASDL_TREE
+
+#include <cstdio>
+#include <cstring>
+#include <stdint.h>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+// Storage, printing and pickling for the node types that asdlgen.py
+// generates from an ASDL module.
+//
+// A tree is a single array of 32 bit words. A node is its kind followed
+// by one word per field, and is referred to by the index of its kind
+// word. What a field word holds depends on the field type:
+//
+//   identifier, string   index into the tree's string table
+//   int                  the value
+//   simple sum           the constructor kind, no node is allocated
+//   any other type       index of the node, ASDL_NONE for a missing '?'
+//   '*' sequence         index of a [count, element...] block,
+//                        ASDL_NONE for the empty sequence
+
+typedef uint32_t asdl_ref;
+typedef vector<asdl_ref> asdl_seq;
+
+const asdl_ref ASDL_NONE = 0xffffffff;
+
+enum asdl_field_type {
+  ASDL_IDENT, ASDL_STRING, ASDL_INT, ASDL_ENUM, ASDL_NODE,
+  ASDL_BASE = 0x0f, ASDL_OPT = 0x10, ASDL_SEQ = 0x20
+};
+
+typedef struct asdl_ctor_info {
+  const char *name;
+  int nfields;
+  const unsigned char *fields;   // asdl_field_type of each field
+} asdl_ctor_info;
+
+typedef struct asdl_schema {
+  const char *module;
+  uint32_t hash;                 // changes whenever the node layout does
+  int nkinds;
+  const asdl_ctor_info *ctors;
+} asdl_schema;
+
+// Pickle format, every word in host byte order:
+//
+//   magic "ASDL", ASDL_PICKLE_VERSION, ASDL_BYTE_ORDER, schema hash,
+//   number of strings, number of words, root
+//   each string as its length followed by its bytes, padded to a word
+//   the tree words
+//
+// Loading checks the header and copies the words back with one memcpy.
+// A pickle from another version, byte order or schema is rejected, so
+// callers can treat it as a stale cache and parse the source again.
+const uint32_t ASDL_MAGIC = 0x4c445341;       // "ASDL"
+const uint32_t ASDL_PICKLE_VERSION = 1;
+const uint32_t ASDL_BYTE_ORDER = 0x01020304;
+const int ASDL_HEADER_WORDS = 7;
+
+class asdl_tree {
+protected:
+  const asdl_schema *schema;
+  unordered_map<string, uint32_t> string_ids;
+
+  asdl_ref alloc(int kind) {
+    asdl_ref n = words.size();
+    words.resize(n + 1 + schema->ctors[kind].nfields);
+    words[n] = kind;
+    return n;
+  }
+  uint32_t intern(const string &s) {
+    unordered_map<string, uint32_t>::iterator i = string_ids.find(s);
+    if (i != string_ids.end()) {
+      return i->second;
+    }
+    uint32_t id = strings.size();
+    strings.push_back(s);
+    string_ids[s] = id;
+    return id;
+  }
+  asdl_ref seq(const asdl_seq *elts) {
+    if (elts == NULL || elts->empty()) {
+      return ASDL_NONE;
+    }
+    asdl_ref n = words.size();
+    words.push_back(elts->size());
+    words.insert(words.end(), elts->begin(), elts->end());
+    return n;
+  }
+
+  // print() and valid() walk a tree from an explicit stack of the fields
+  // still to visit, as trees nest far deeper than the native stack
+  // allows: a long a+b+c+... is a chain of BinaryExpr nodes. A
+  // print_text item writes the character in its word instead.
+  typedef pair<unsigned char, uint32_t> asdl_item;
+  enum { print_text = 0x40 };
+
+  // push the fields of node n, the first one on top
+  void push_fields(vector<asdl_item> &work, asdl_ref n, bool commas) const {
+    const asdl_ctor_info &c = schema->ctors[words[n]];
+    for (int i = c.nfields - 1; i >= 0; i--) {
+      work.push_back(asdl_item(c.fields[i], words[n + 1 + i]));
+      if (commas && i > 0) {
+        work.push_back(asdl_item(print_text, ','));
+      }
+    }
+  }
+  // push the elements of sequence block w, the first one on top
+  void push_elements(vector<asdl_item> &work, unsigned char type, uint32_t w, bool commas) const {
+    for (uint32_t i = words[w]; i >= 1; i--) {
+      work.push_back(asdl_item(type & ASDL_BASE, words[w + i]));
+      if (commas && i > 1) {
+        work.push_back(asdl_item(print_text, ','));
+      }
+    }
+  }
+
+  // a loaded tree is only printed after every reference in it is known
+  // to be in range, so a corrupt pickle cannot make print() misbehave.
+  // A tree refers to each of its nodes and sequences once, so visiting
+  // more of them than there are words means the pickle has a cycle.
+  bool valid(asdl_ref n) const {
+    vector<asdl_item> work(1, asdl_item(ASDL_NODE, n));
+    size_t visits = 0;
+    while (!work.empty()) {
+      unsigned char type = work.back().first;
+      uint32_t w = work.back().second;
+      work.pop_back();
+      if (type & ASDL_SEQ) {
+        if (w == ASDL_NONE) {
+          continue;
+        }
+        if (++visits > words.size() || w >= words.size() || words[w] > words.size() - w - 1) {
+          return false;
+        }
+        push_elements(work, type, w, false);
+        continue;
+      }
+      if (w == ASDL_NONE && (type & ASDL_OPT)) {
+        continue;
+      }
+      switch (type & ASDL_BASE) {
+      case ASDL_IDENT:
+      case ASDL_STRING:
+        if (w >= strings.size()) {
+          return false;
+        }
+        break;
+      case ASDL_INT:
+        break;
+      case ASDL_ENUM:
+        if (w >= (uint32_t)schema->nkinds || schema->ctors[w].nfields != 0) {
+          return false;
+        }
+        break;
+      default:
+        if (++visits > words.size() || w >= words.size() || words[w] >= (uint32_t)schema->nkinds) {
+          return false;
+        }
+        const asdl_ctor_info &c = schema->ctors[words[w]];
+        if (c.nfields > 0 && words.size() - w - 1 < (size_t)c.nfields) {
+          return false;
+        }
+        push_fields(work, w, false);
+        break;
+      }
+    }
+    return true;
+  }
+
+public:
+  vector<uint32_t> words;
+  vector<string> strings;
+  asdl_ref root;
+
+  asdl_tree(const asdl_schema *s) : schema(s), root(ASDL_NONE) {}
+
+  int kind(asdl_ref n) const { return words[n]; }
+
+  // print node n in the same sexp syntax the decaf tools have always used
+  void print(ostream &out, asdl_ref n) const {
+    vector<asdl_item> work(1, asdl_item(ASDL_NODE, n));
+    while (!work.empty()) {
+      unsigned char type = work.back().first;
+      uint32_t w = work.back().second;
+      work.pop_back();
+      if (type == print_text) {
+        out << (char)w;
+        continue;
+      }
+      if (type & ASDL_SEQ) {
+        if (w == ASDL_NONE) {
+          out << "None";
+        } else {
+          push_elements(work, type, w, true);
+        }
+        continue;
+      }
+      if (w == ASDL_NONE && (type & ASDL_OPT)) {
+        out << "None";
+        continue;
+      }
+      switch (type & ASDL_BASE) {
+      case ASDL_IDENT:
+      case ASDL_STRING: out << strings[w]; break;
+      case ASDL_INT: out << (int32_t)w; break;
+      case ASDL_ENUM: out << schema->ctors[w].name; break;
+      default:
+        out << schema->ctors[words[w]].name;
+        if (schema->ctors[words[w]].nfields > 0) {
+          out << '(';
+          work.push_back(asdl_item(print_text, ')'));
+          push_fields(work, w, true);
+        }
+        break;
+      }
+    }
+  }
+
+  bool save(FILE *fp) const {
+    uint32_t header[ASDL_HEADER_WORDS] = {
+      ASDL_MAGIC, ASDL_PICKLE_VERSION, ASDL_BYTE_ORDER, schema->hash,
+      (uint32_t)strings.size(), (uint32_t)words.size(), root
+    };
+    if (fwrite(header, sizeof(header), 1, fp) != 1) {
+      return false;
+    }
+    static const char pad[4] = { 0, 0, 0, 0 };
+    for (size_t i = 0; i < strings.size(); i++) {
+      uint32_t len = strings[i].size();
+      if (fwrite(&len, sizeof(len), 1, fp) != 1
+          || fwrite(strings[i].data(), 1, len, fp) != len
+          || fwrite(pad, 1, (4 - len % 4) % 4, fp) != (4 - len % 4) % 4) {
+        return false;
+      }
+    }
+    return words.empty() || fwrite(&words[0], sizeof(uint32_t), words.size(), fp) == words.size();
+  }
+
+  // load a pickle from memory, buf must be word aligned
+  bool load(const char *buf, size_t len) {
+    const uint32_t *p = (const uint32_t *)buf;
+    const uint32_t *end = p + len / sizeof(uint32_t);
+    if (len < ASDL_HEADER_WORDS * sizeof(uint32_t)
+        || p[0] != ASDL_MAGIC || p[1] != ASDL_PICKLE_VERSION
+        || p[2] != ASDL_BYTE_ORDER || p[3] != schema->hash) {
+      return false;
+    }
+    uint32_t nstrings = p[4], nwords = p[5];
+    root = p[6];
+    p += ASDL_HEADER_WORDS;
+    strings.clear();
+    string_ids.clear();
+    strings.reserve(nstrings < len / 4 ? nstrings : len / 4);
+    for (uint32_t i = 0; i < nstrings; i++) {
+      if (p >= end || (size_t)(end - p - 1) < ((size_t)*p + 3) / 4) {
+        return false;
+      }
+      strings.push_back(string((const char *)(p + 1), *p));
+      p += 1 + ((size_t)*p + 3) / 4;
+    }
+    if ((size_t)(end - p) != nwords) {
+      return false;
+    }
+    words.assign(p, end);
+    return valid(root);
+  }
+};
+
+#endif
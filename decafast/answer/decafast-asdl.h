@@ -0,0 +1,368 @@
+// generated by asdlgen.py from Decaf.asdl, do not edit
+
+#ifndef _DECAF_ASDL
+#define _DECAF_ASDL
+
+#include "asdl.h"
+
+// one kind per constructor, the first word of its nodes
+enum decaf_kind {
+  Program_kind,
+  ExternFunction_kind,
+  IntType_kind,
+  BoolType_kind,
+  VoidType_kind,
+  extern_type_VarDef_kind,
+  StringType_kind,
+  Package_kind,
+  FieldDecl_kind,
+  AssignGlobalVar_kind,
+  Scalar_kind,
+  Array_kind,
+  Method_kind,
+  typed_symbol_VarDef_kind,
+  MethodBlock_kind,
+  Block_kind,
+  IfStmt_kind,
+  WhileStmt_kind,
+  ForStmt_kind,
+  ReturnStmt_kind,
+  BreakStmt_kind,
+  ContinueStmt_kind,
+  AssignVar_kind,
+  AssignArrayLoc_kind,
+  MethodCall_kind,
+  StringConstant_kind,
+  BinaryExpr_kind,
+  UnaryExpr_kind,
+  NumberExpr_kind,
+  BoolExpr_kind,
+  VariableExpr_kind,
+  ArrayLocExpr_kind,
+  True_kind,
+  False_kind,
+  Plus_kind,
+  Minus_kind,
+  Mult_kind,
+  Div_kind,
+  Leftshift_kind,
+  Rightshift_kind,
+  Mod_kind,
+  Lt_kind,
+  Gt_kind,
+  Leq_kind,
+  Geq_kind,
+  Eq_kind,
+  Neq_kind,
+  And_kind,
+  Or_kind,
+  UnaryMinus_kind,
+  Not_kind,
+  decaf_num_kinds
+};
+
+// word offsets of the fields within a node
+enum decaf_field {
+  Program_extern_list = 1,
+  Program_body = 2,
+  ExternFunction_name = 1,
+  ExternFunction_return_type = 2,
+  ExternFunction_typelist = 3,
+  extern_type_VarDef_arg0 = 1,
+  Package_name = 1,
+  Package_field_list = 2,
+  Package_method_list = 3,
+  FieldDecl_name = 1,
+  FieldDecl_type = 2,
+  FieldDecl_size = 3,
+  AssignGlobalVar_name = 1,
+  AssignGlobalVar_type = 2,
+  AssignGlobalVar_value = 3,
+  Array_array_size = 1,
+  Method_name = 1,
+  Method_return_type = 2,
+  Method_param_list = 3,
+  Method_block = 4,
+  typed_symbol_VarDef_name = 1,
+  typed_symbol_VarDef_type = 2,
+  MethodBlock_var_decl_list = 1,
+  MethodBlock_statement_list = 2,
+  Block_var_decl_list = 1,
+  Block_statement_list = 2,
+  IfStmt_condition = 1,
+  IfStmt_if_block = 2,
+  IfStmt_else_block = 3,
+  WhileStmt_condition = 1,
+  WhileStmt_while_block = 2,
+  ForStmt_pre_assign_list = 1,
+  ForStmt_condition = 2,
+  ForStmt_loop_assign_list = 3,
+  ForStmt_for_block = 4,
+  ReturnStmt_return_value = 1,
+  AssignVar_name = 1,
+  AssignVar_value = 2,
+  AssignArrayLoc_name = 1,
+  AssignArrayLoc_index = 2,
+  AssignArrayLoc_value = 3,
+  MethodCall_name = 1,
+  MethodCall_method_arg_list = 2,
+  StringConstant_value = 1,
+  BinaryExpr_op = 1,
+  BinaryExpr_left_value = 2,
+  BinaryExpr_right_value = 3,
+  UnaryExpr_op = 1,
+  UnaryExpr_value = 2,
+  NumberExpr_value = 1,
+  BoolExpr_value = 1,
+  VariableExpr_name = 1,
+  ArrayLocExpr_name = 1,
+  ArrayLocExpr_index = 2
+};
+
+static const unsigned char Program_fields[] = { ASDL_NODE|ASDL_SEQ, ASDL_NODE };
+static const unsigned char ExternFunction_fields[] = { ASDL_IDENT, ASDL_ENUM, ASDL_NODE|ASDL_SEQ };
+static const unsigned char extern_type_VarDef_fields[] = { ASDL_ENUM };
+static const unsigned char Package_fields[] = { ASDL_IDENT, ASDL_NODE|ASDL_SEQ, ASDL_NODE|ASDL_SEQ };
+static const unsigned char FieldDecl_fields[] = { ASDL_IDENT, ASDL_ENUM, ASDL_NODE };
+static const unsigned char AssignGlobalVar_fields[] = { ASDL_IDENT, ASDL_ENUM, ASDL_NODE };
+static const unsigned char Array_fields[] = { ASDL_INT };
+static const unsigned char Method_fields[] = { ASDL_IDENT, ASDL_ENUM, ASDL_NODE|ASDL_SEQ, ASDL_NODE };
+static const unsigned char typed_symbol_VarDef_fields[] = { ASDL_IDENT, ASDL_ENUM };
+static const unsigned char MethodBlock_fields[] = { ASDL_NODE|ASDL_SEQ, ASDL_NODE|ASDL_SEQ };
+static const unsigned char Block_fields[] = { ASDL_NODE|ASDL_SEQ, ASDL_NODE|ASDL_SEQ };
+static const unsigned char IfStmt_fields[] = { ASDL_NODE, ASDL_NODE, ASDL_NODE|ASDL_OPT };
+static const unsigned char WhileStmt_fields[] = { ASDL_NODE, ASDL_NODE };
+static const unsigned char ForStmt_fields[] = { ASDL_NODE|ASDL_SEQ, ASDL_NODE, ASDL_NODE|ASDL_SEQ, ASDL_NODE };
+static const unsigned char ReturnStmt_fields[] = { ASDL_NODE|ASDL_OPT };
+static const unsigned char AssignVar_fields[] = { ASDL_IDENT, ASDL_NODE };
+static const unsigned char AssignArrayLoc_fields[] = { ASDL_IDENT, ASDL_NODE, ASDL_NODE };
+static const unsigned char MethodCall_fields[] = { ASDL_IDENT, ASDL_NODE|ASDL_SEQ };
+static const unsigned char StringConstant_fields[] = { ASDL_STRING };
+static const unsigned char BinaryExpr_fields[] = { ASDL_ENUM, ASDL_NODE, ASDL_NODE };
+static const unsigned char UnaryExpr_fields[] = { ASDL_ENUM, ASDL_NODE };
+static const unsigned char NumberExpr_fields[] = { ASDL_INT };
+static const unsigned char BoolExpr_fields[] = { ASDL_ENUM };
+static const unsigned char VariableExpr_fields[] = { ASDL_IDENT };
+static const unsigned char ArrayLocExpr_fields[] = { ASDL_IDENT, ASDL_NODE };
+
+static const asdl_ctor_info decaf_ctors[] = {
+  { "Program", 2, Program_fields },
+  { "ExternFunction", 3, ExternFunction_fields },
+  { "IntType", 0, NULL },
+  { "BoolType", 0, NULL },
+  { "VoidType", 0, NULL },
+  { "VarDef", 1, extern_type_VarDef_fields },
+  { "StringType", 0, NULL },
+  { "Package", 3, Package_fields },
+  { "FieldDecl", 3, FieldDecl_fields },
+  { "AssignGlobalVar", 3, AssignGlobalVar_fields },
+  { "Scalar", 0, NULL },
+  { "Array", 1, Array_fields },
+  { "Method", 4, Method_fields },
+  { "VarDef", 2, typed_symbol_VarDef_fields },
+  { "MethodBlock", 2, MethodBlock_fields },
+  { "Block", 2, Block_fields },
+  { "IfStmt", 3, IfStmt_fields },
+  { "WhileStmt", 2, WhileStmt_fields },
+  { "ForStmt", 4, ForStmt_fields },
+  { "ReturnStmt", 1, ReturnStmt_fields },
+  { "BreakStmt", 0, NULL },
+  { "ContinueStmt", 0, NULL },
+  { "AssignVar", 2, AssignVar_fields },
+  { "AssignArrayLoc", 3, AssignArrayLoc_fields },
+  { "MethodCall", 2, MethodCall_fields },
+  { "StringConstant", 1, StringConstant_fields },
+  { "BinaryExpr", 3, BinaryExpr_fields },
+  { "UnaryExpr", 2, UnaryExpr_fields },
+  { "NumberExpr", 1, NumberExpr_fields },
+  { "BoolExpr", 1, BoolExpr_fields },
+  { "VariableExpr", 1, VariableExpr_fields },
+  { "ArrayLocExpr", 2, ArrayLocExpr_fields },
+  { "True", 0, NULL },
+  { "False", 0, NULL },
+  { "Plus", 0, NULL },
+  { "Minus", 0, NULL },
+  { "Mult", 0, NULL },
+  { "Div", 0, NULL },
+  { "Leftshift", 0, NULL },
+  { "Rightshift", 0, NULL },
+  { "Mod", 0, NULL },
+  { "Lt", 0, NULL },
+  { "Gt", 0, NULL },
+  { "Leq", 0, NULL },
+  { "Geq", 0, NULL },
+  { "Eq", 0, NULL },
+  { "Neq", 0, NULL },
+  { "And", 0, NULL },
+  { "Or", 0, NULL },
+  { "UnaryMinus", 0, NULL },
+  { "Not", 0, NULL },
+};
+
+static const asdl_schema decaf_schema = { "Decaf", 0x4fb8e5de, decaf_num_kinds, decaf_ctors };
+
+// decaf_tree - an asdl_tree with one constructor method per node kind
+class decaf_tree : public asdl_tree {
+public:
+  decaf_tree() : asdl_tree(&decaf_schema) {}
+  asdl_ref Program(const asdl_seq *extern_list, asdl_ref body) {
+    asdl_ref n = alloc(Program_kind);
+    words[n + Program_extern_list] = seq(extern_list);
+    words[n + Program_body] = body;
+    return n;
+  }
+  asdl_ref ExternFunction(const string &name, decaf_kind return_type, const asdl_seq *typelist) {
+    asdl_ref n = alloc(ExternFunction_kind);
+    words[n + ExternFunction_name] = intern(name);
+    words[n + ExternFunction_return_type] = return_type;
+    words[n + ExternFunction_typelist] = seq(typelist);
+    return n;
+  }
+  asdl_ref extern_type_VarDef(decaf_kind arg0) {
+    asdl_ref n = alloc(extern_type_VarDef_kind);
+    words[n + extern_type_VarDef_arg0] = arg0;
+    return n;
+  }
+  asdl_ref StringType() { return alloc(StringType_kind); }
+  asdl_ref Package(const string &name, const asdl_seq *field_list, const asdl_seq *method_list) {
+    asdl_ref n = alloc(Package_kind);
+    words[n + Package_name] = intern(name);
+    words[n + Package_field_list] = seq(field_list);
+    words[n + Package_method_list] = seq(method_list);
+    return n;
+  }
+  asdl_ref FieldDecl(const string &name, decaf_kind type, asdl_ref size) {
+    asdl_ref n = alloc(FieldDecl_kind);
+    words[n + FieldDecl_name] = intern(name);
+    words[n + FieldDecl_type] = type;
+    words[n + FieldDecl_size] = size;
+    return n;
+  }
+  asdl_ref AssignGlobalVar(const string &name, decaf_kind type, asdl_ref value) {
+    asdl_ref n = alloc(AssignGlobalVar_kind);
+    words[n + AssignGlobalVar_name] = intern(name);
+    words[n + AssignGlobalVar_type] = type;
+    words[n + AssignGlobalVar_value] = value;
+    return n;
+  }
+  asdl_ref Scalar() { return alloc(Scalar_kind); }
+  asdl_ref Array(int32_t array_size) {
+    asdl_ref n = alloc(Array_kind);
+    words[n + Array_array_size] = (uint32_t)array_size;
+    return n;
+  }
+  asdl_ref Method(const string &name, decaf_kind return_type, const asdl_seq *param_list, asdl_ref block) {
+    asdl_ref n = alloc(Method_kind);
+    words[n + Method_name] = intern(name);
+    words[n + Method_return_type] = return_type;
+    words[n + Method_param_list] = seq(param_list);
+    words[n + Method_block] = block;
+    return n;
+  }
+  asdl_ref typed_symbol_VarDef(const string &name, decaf_kind type) {
+    asdl_ref n = alloc(typed_symbol_VarDef_kind);
+    words[n + typed_symbol_VarDef_name] = intern(name);
+    words[n + typed_symbol_VarDef_type] = type;
+    return n;
+  }
+  asdl_ref MethodBlock(const asdl_seq *var_decl_list, const asdl_seq *statement_list) {
+    asdl_ref n = alloc(MethodBlock_kind);
+    words[n + MethodBlock_var_decl_list] = seq(var_decl_list);
+    words[n + MethodBlock_statement_list] = seq(statement_list);
+    return n;
+  }
+  asdl_ref Block(const asdl_seq *var_decl_list, const asdl_seq *statement_list) {
+    asdl_ref n = alloc(Block_kind);
+    words[n + Block_var_decl_list] = seq(var_decl_list);
+    words[n + Block_statement_list] = seq(statement_list);
+    return n;
+  }
+  asdl_ref IfStmt(asdl_ref condition, asdl_ref if_block, asdl_ref else_block) {
+    asdl_ref n = alloc(IfStmt_kind);
+    words[n + IfStmt_condition] = condition;
+    words[n + IfStmt_if_block] = if_block;
+    words[n + IfStmt_else_block] = else_block;
+    return n;
+  }
+  asdl_ref WhileStmt(asdl_ref condition, asdl_ref while_block) {
+    asdl_ref n = alloc(WhileStmt_kind);
+    words[n + WhileStmt_condition] = condition;
+    words[n + WhileStmt_while_block] = while_block;
+    return n;
+  }
+  asdl_ref ForStmt(const asdl_seq *pre_assign_list, asdl_ref condition, const asdl_seq *loop_assign_list, asdl_ref for_block) {
+    asdl_ref n = alloc(ForStmt_kind);
+    words[n + ForStmt_pre_assign_list] = seq(pre_assign_list);
+    words[n + ForStmt_condition] = condition;
+    words[n + ForStmt_loop_assign_list] = seq(loop_assign_list);
+    words[n + ForStmt_for_block] = for_block;
+    return n;
+  }
+  asdl_ref ReturnStmt(asdl_ref return_value) {
+    asdl_ref n = alloc(ReturnStmt_kind);
+    words[n + ReturnStmt_return_value] = return_value;
+    return n;
+  }
+  asdl_ref BreakStmt() { return alloc(BreakStmt_kind); }
+  asdl_ref ContinueStmt() { return alloc(ContinueStmt_kind); }
+  asdl_ref AssignVar(const string &name, asdl_ref value) {
+    asdl_ref n = alloc(AssignVar_kind);
+    words[n + AssignVar_name] = intern(name);
+    words[n + AssignVar_value] = value;
+    return n;
+  }
+  asdl_ref AssignArrayLoc(const string &name, asdl_ref index, asdl_ref value) {
+    asdl_ref n = alloc(AssignArrayLoc_kind);
+    words[n + AssignArrayLoc_name] = intern(name);
+    words[n + AssignArrayLoc_index] = index;
+    words[n + AssignArrayLoc_value] = value;
+    return n;
+  }
+  asdl_ref MethodCall(const string &name, const asdl_seq *method_arg_list) {
+    asdl_ref n = alloc(MethodCall_kind);
+    words[n + MethodCall_name] = intern(name);
+    words[n + MethodCall_method_arg_list] = seq(method_arg_list);
+    return n;
+  }
+  asdl_ref StringConstant(const string &value) {
+    asdl_ref n = alloc(StringConstant_kind);
+    words[n + StringConstant_value] = intern(value);
+    return n;
+  }
+  asdl_ref BinaryExpr(decaf_kind op, asdl_ref left_value, asdl_ref right_value) {
+    asdl_ref n = alloc(BinaryExpr_kind);
+    words[n + BinaryExpr_op] = op;
+    words[n + BinaryExpr_left_value] = left_value;
+    words[n + BinaryExpr_right_value] = right_value;
+    return n;
+  }
+  asdl_ref UnaryExpr(decaf_kind op, asdl_ref value) {
+    asdl_ref n = alloc(UnaryExpr_kind);
+    words[n + UnaryExpr_op] = op;
+    words[n + UnaryExpr_value] = value;
+    return n;
+  }
+  asdl_ref NumberExpr(int32_t value) {
+    asdl_ref n = alloc(NumberExpr_kind);
+    words[n + NumberExpr_value] = (uint32_t)value;
+    return n;
+  }
+  asdl_ref BoolExpr(decaf_kind value) {
+    asdl_ref n = alloc(BoolExpr_kind);
+    words[n + BoolExpr_value] = value;
+    return n;
+  }
+  asdl_ref VariableExpr(const string &name) {
+    asdl_ref n = alloc(VariableExpr_kind);
+    words[n + VariableExpr_name] = intern(name);
+    return n;
+  }
+  asdl_ref ArrayLocExpr(const string &name, asdl_ref index) {
+    asdl_ref n = alloc(ArrayLocExpr_kind);
+    words[n + ArrayLocExpr_name] = intern(name);
+    words[n + ArrayLocExpr_index] = index;
+    return n;
+  }
+};
+
+#endif
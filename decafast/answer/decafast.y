@@ -4,44 +4,64 @@
 #include <string>
 #include <cstdlib>
 #include "default-defs.h"
-
-int yylex(void);
-int yyerror(char *); 
+#include "decaf-input.h"
 
 // print AST?
 bool printAST = true;
+// print the AST indented instead of on one line (-i)
+bool indentAST = false;
 
 #include "decafast.cc"
 
 using namespace std;
 
+// the parse stack is on the heap and grows as needed, and neither the
+// printer nor the pickle recurses on the depth of the AST, so allow far
+// more nesting than bison's default of 10000.
+#define YYMAXDEPTH 10000000
+
 %}
 
 %define parse.error verbose
 
+// a pure parser with a reentrant scanner: the parse keeps its state on
+// the stack, in the yyscan_t and in the tree it builds, so files can be
+// parsed on different threads
+%define api.pure full
+%locations
+%param {yyscan_t scanner}
+%parse-param {decaf_tree &tree}
+
+%code provides {
+int yylex(YYSTYPE *lval, YYLTYPE *lloc, yyscan_t scanner);
+int yyerror(YYLTYPE *loc, yyscan_t scanner, decaf_tree &tree, const char *s);
+}
+
 %union{
-    class decafAST *ast;
+    asdl_ref ast;
+    asdl_seq *seq;
+    decaf_kind kind;
     std::string *sval;
     arr s;
     std::vector<std::string> *vecptr;
  }
 
 %token T_VAR
-%token <sval> T_SEMICOLON
+%token T_SEMICOLON
 %token T_COMMA
-%token <sval> T_INTTYPE
+%token <kind> T_INTTYPE
 %token T_LSB
 %token <sval> T_INTCONSTANT
 %token T_RSB
 %token T_ASSIGN
-%token <sval> T_BOOLTYPE
+%token <kind> T_BOOLTYPE
 %token <sval> T_CHARCONSTANT
-%token <sval> T_TRUE
-%token <sval> T_FALSE
+%token <kind> T_TRUE
+%token <kind> T_FALSE
 
 %token T_LPAREN
 %token T_RPAREN
-%token <sval> T_STRINGTYPE
+%token <kind> T_STRINGTYPE
 %token T_EXTERN
 %token T_FUNC
 
@@ -49,23 +69,25 @@ using namespace std;
 %token T_LCB
 %token T_RCB
 %token <sval> T_ID
-%token <sval> T_VOID
+%token <kind> T_VOID
 
-%type <ast> method_decls method_parameter_list method_block
+%type <seq> method_decls method_parameter_list method_parameters
+%type <ast> method_block
 
-%type <ast> extern_type_list
-%type <sval> extern_type method_type arithmetic_operator boolean_operator
+%type <seq> extern_type_list extern_types
+%type <kind> extern_type method_type arithmetic_operator boolean_operator
 
-%type <ast> extern_list decafpackage
+%type <seq> extern_list
+%type <ast> decafpackage
 
-%type <ast> field_decls field_decl
+%type <seq> field_decls field_decl
 
-%type <sval> decaf_type binary_operator unary_operator
+%type <kind> decaf_type binary_operator unary_operator
 %type <ast> constant
 %type <s> array_type
 %type <vecptr> id_list
 
-%token <sval> T_PLUS T_MINUS T_DIV T_MULT T_MOD T_EQ T_NEQ T_LEFTSHIFT T_RIGHTSHIFT T_LT T_GT T_GEQ T_LEQ T_AND T_OR T_NOT
+%token <kind> T_PLUS T_MINUS T_DIV T_MULT T_MOD T_EQ T_NEQ T_LEFTSHIFT T_RIGHTSHIFT T_LT T_GT T_GEQ T_LEQ T_AND T_OR T_NOT
 
 %left T_OR
 %left T_AND
@@ -80,10 +102,11 @@ using namespace std;
 %token T_FOR
 %token T_ELSE
 %token T_RETURN
-%token <sval> T_CONTINUE
-%token <sval> T_BREAK
+%token T_CONTINUE
+%token T_BREAK
 %token <sval> T_STRINGCONSTANT
-%type <ast> var_decls var_decl statements statement assign assign_list return_stmt if_stmt while_stmt for_stmt block expr method_arg method_arg_list method_call
+%type <seq> var_decls var_decl statements assign_list method_arg_list method_args
+%type <ast> statement assign return_stmt if_stmt while_stmt for_stmt block expr method_arg method_call
 
 %%
 
@@ -91,51 +114,38 @@ start: program
     ;
 
 program: extern_list decafpackage
-    { 
-        ProgramAST *prog = new ProgramAST((decafStmtList *)$1, (PackageAST *)$2); 
-		if (printAST) {
-			cout << getString(prog) << endl;
-		}
-        delete prog;
+    {
+        tree.root = tree.Program($1, $2);
+        delete $1;
     }
     ;
 
 extern_list: /* extern_list can be empty */
-    { decafStmtList *slist = new decafStmtList(); $$ = slist; }
-    | T_EXTERN T_FUNC T_ID T_LPAREN extern_type_list T_RPAREN method_type T_SEMICOLON extern_list
+    { $$ = NULL; }
+    | extern_list T_EXTERN T_FUNC T_ID T_LPAREN extern_type_list T_RPAREN method_type T_SEMICOLON
     {
-        decafStmtList* slist;
-        ExternFunctionAST *ex;
-        if($9 == NULL) {
-            slist = new decafStmtList();
-        }
-        else {
-            slist = (decafStmtList *)$9;
-        }
-        ex = new ExternFunctionAST(*$3, *$7, (decafStmtList *)$5);
-        slist->push_front(ex);
-        $$ = slist;
+        $$ = append($1, tree.ExternFunction(*$4, $8, $6));
+        delete $4; delete $6;
     }
     ;
 
-extern_type_list: extern_type T_COMMA extern_type_list
+/* a trailing comma is allowed */
+extern_type_list: extern_types
+    { $$ = $1; }
+    | extern_types T_COMMA
+    { $$ = $1; }
+    |
+    { $$ = NULL; }
+    ;
+
+extern_types: extern_types T_COMMA extern_type
     {
-        decafStmtList* elist;
-        VarDefAST *ex = new VarDefAST(*$1);
-        elist = (decafStmtList *)$3;
-        elist->push_front(ex);
-        $$ = elist;
+        $$ = append($1, tree.extern_type_VarDef($3));
     }
     | extern_type
     {
-        decafStmtList* elist;
-        elist = new decafStmtList();
-        VarDefAST *ex = new VarDefAST(*$1);
-        elist->push_front(ex);
-        $$ = elist;
+        $$ = append(NULL, tree.extern_type_VarDef($1));
     }
-    | 
-    { $$ = NULL; }
     ;
 
 extern_type: decaf_type
@@ -157,53 +167,44 @@ method_type: decaf_type
     ;
 
 decafpackage: T_PACKAGE T_ID T_LCB field_decls method_decls T_RCB
-    { $$ = new PackageAST(*$2, (decafStmtList *)$4, (decafStmtList *)$5); delete $2; }
+    { $$ = tree.Package(*$2, $4, $5); delete $2; delete $4; delete $5; }
     ;
 
 field_decls:
     { $$ = NULL; }
-    | field_decl field_decls
+    | field_decls field_decl
     {
-        decafStmtList* slist;
-        if($2 == NULL) {
-            slist = new decafStmtList();
-        }
-        else {
-            slist = (decafStmtList *)$2;
-        }
-        slist->push_front($1);
-        $$ = slist;
+        $$ = append_all($1, $2);
     }
     ;
 
 field_decl: T_VAR id_list decaf_type T_SEMICOLON
     {
-        decafStmtList* slist = new decafStmtList();
-        FieldDeclAST* node;
+        asdl_seq* slist = new asdl_seq;
         for(int i = 0; i < $2->size(); i++) {
-            node = new FieldDeclAST((*$2)[i], *$3, "Scalar", false);
-            slist->push_back(node);
+            slist->push_back(tree.FieldDecl((*$2)[i], $3, tree.Scalar()));
         }
+        delete $2;
         $$ = slist;
     }
     | T_VAR id_list array_type T_SEMICOLON
     {
-        decafStmtList* slist = new decafStmtList();
-        FieldDeclAST* node;
+        asdl_seq* slist = new asdl_seq;
         for(int i = 0; i < $2->size(); i++) {
-            node = new FieldDeclAST((*$2)[i], *$3.type, *$3.size, false);
-            slist->push_back(node);
+            slist->push_back(tree.FieldDecl((*$2)[i], (decaf_kind)$3.type, tree.Array($3.size)));
         }
+        delete $2;
         $$ = slist;
     }
     | T_VAR id_list decaf_type T_ASSIGN constant T_SEMICOLON
     {
-        $$ = new FieldDeclAST((*$2)[0], *$3, getString((decafAST *)$5), true);
+        $$ = append(NULL, tree.AssignGlobalVar((*$2)[0], $3, $5));
+        delete $2;
     }
     ;
 
 id_list: T_ID T_COMMA id_list
-    {  
+    {
         vector<string>* ilist;
         ilist = $3;
         ilist->insert(ilist->begin(), *$1);
@@ -211,7 +212,7 @@ id_list: T_ID T_COMMA id_list
         $$ = ilist;
     }
     | T_ID
-    {  
+    {
         vector<string>* ilist;
         ilist = new vector<string>;
         ilist->insert(ilist->begin(), *$1);
@@ -223,71 +224,53 @@ id_list: T_ID T_COMMA id_list
 array_type: T_LSB T_INTCONSTANT T_RSB decaf_type
     {
         arr s;
-        s.size = $2;
+        s.size = itoi(*$2);
         s.type = $4;
+        delete $2;
         $$ = s;
     }
     ;
 
-method_decls: 
+method_decls:
     { $$ = NULL; }
-    | T_FUNC T_ID T_LPAREN method_parameter_list T_RPAREN method_type method_block method_decls
+    | method_decls T_FUNC T_ID T_LPAREN method_parameter_list T_RPAREN method_type method_block
     {
-        decafStmtList* slist;
-        MethodDeclAST *method;
-        if($8 == NULL) {
-            slist = new decafStmtList();
-        }
-        else {
-            slist = (decafStmtList *)$8;
-        }
-        method = new MethodDeclAST(*$2, *$6, (decafStmtList *)$4, (decafStmtList *)$7);
-        slist->push_front(method);
-        $$ = slist;
+        $$ = append($1, tree.Method(*$3, $7, $5, $8));
+        delete $3; delete $5;
     }
     ;
 
-method_parameter_list: 
+/* a trailing comma is allowed */
+method_parameter_list:
     { $$ = NULL; }
-    | T_ID decaf_type T_COMMA method_parameter_list
+    | method_parameters
+    { $$ = $1; }
+    | method_parameters T_COMMA
+    { $$ = $1; }
+    ;
+
+method_parameters: method_parameters T_COMMA T_ID decaf_type
     {
-        decafStmtList* mplist;
-        MethodVarDefAST *mv = new MethodVarDefAST(*$1, *$2);
-        mplist = (decafStmtList *)$4;
-        mplist->push_front(mv);
-        $$ = mplist;
+        $$ = append($1, tree.typed_symbol_VarDef(*$3, $4));
+        delete $3;
     }
     | T_ID decaf_type
     {
-        decafStmtList* mplist;
-        mplist = new decafStmtList();
-        MethodVarDefAST *mv = new MethodVarDefAST(*$1, *$2);
-        mplist->push_front(mv);
-        $$ = mplist;
+        $$ = append(NULL, tree.typed_symbol_VarDef(*$1, $2));
+        delete $1;
     }
-    | 
-    { $$ = NULL; }
     ;
 
 method_block: T_LCB var_decls statements T_RCB
     {
-        MethodBlockAST *block;
-        block = new MethodBlockAST((decafStmtList *)$2, (decafStmtList *)$3);
-        $$ = block;
+        $$ = tree.MethodBlock($2, $3);
+        delete $2; delete $3;
     }
     ;
 
-var_decls: var_decl var_decls
+var_decls: var_decls var_decl
     {
-        decafStmtList* vdlist;
-        if($2 == NULL) {
-            vdlist = new decafStmtList();
-        }
-        else {
-            vdlist = (decafStmtList *)$2;
-        }
-        vdlist->push_front($1);
-        $$ = vdlist;
+        $$ = append_all($1, $2);
     }
     |
     { $$ = NULL; }
@@ -295,27 +278,18 @@ var_decls: var_decl var_decls
 
 var_decl: T_VAR id_list decaf_type T_SEMICOLON
     {
-        decafStmtList* vdlist = new decafStmtList();
-        MethodVarDefAST* vd;
+        asdl_seq* vdlist = new asdl_seq;
         for(int i = 0; i < $2->size(); i++) {
-            vd = new MethodVarDefAST((*$2)[i], *$3);
-            vdlist->push_back(vd);
+            vdlist->push_back(tree.typed_symbol_VarDef((*$2)[i], $3));
         }
+        delete $2;
         $$ = vdlist;
     }
     ;
 
-statements: statement statements
+statements: statements statement
     {
-        decafStmtList* slist;
-        if($2 == NULL) {
-            slist = new decafStmtList();
-        }
-        else {
-            slist = (decafStmtList *)$2;
-        }
-        slist->push_front($1);
-        $$ = slist;
+        $$ = append($1, $2);
     }
     |
     { $$ = NULL; }
@@ -336,176 +310,90 @@ statement: block
     | for_stmt
     { $$ = $1; }
     | T_BREAK T_SEMICOLON
-    {
-        decafStr *str_id = new decafStr(*$1);
-        $$ = str_id;
-    }
+    { $$ = tree.BreakStmt(); }
     | T_CONTINUE T_SEMICOLON
-    {
-        decafStr *str_id = new decafStr(*$1);
-        $$ = str_id;
-    }
+    { $$ = tree.ContinueStmt(); }
     ;
 
 block: T_LCB var_decls statements T_RCB
     {
-        BlockAST *block;
-        block = new BlockAST((decafStmtList *)$2, (decafStmtList *)$3);
-        $$ = block;
+        $$ = tree.Block($2, $3);
+        delete $2; delete $3;
     }
     ;
 
 expr: T_ID
-    { 
-        decafStr *id = new decafStr( string("VariableExpr") + "(" + *$1 + ")" );
-        $$ = id;
+    {
+        $$ = tree.VariableExpr(*$1);
+        delete $1;
     }
     | method_call
     { $$ = $1; }
     | constant
     { $$ = $1; }
     | expr T_PLUS expr
-    {
-        BinaryExpr *b;
-        b = new BinaryExpr(*$2, (decafAST *)$1, (decafAST *)$3);
-        $$ = b;
-    }
+    { $$ = tree.BinaryExpr($2, $1, $3); }
     | expr T_MINUS expr
-    {
-        BinaryExpr *b;
-        b = new BinaryExpr(*$2, (decafAST *)$1, (decafAST *)$3);
-        $$ = b;
-    }
+    { $$ = tree.BinaryExpr($2, $1, $3); }
     | expr T_MULT expr
-    {
-        BinaryExpr *b;
-        b = new BinaryExpr(*$2, (decafAST *)$1, (decafAST *)$3);
-        $$ = b;
-    }
+    { $$ = tree.BinaryExpr($2, $1, $3); }
     | expr T_DIV expr
-    {
-        BinaryExpr *b;
-        b = new BinaryExpr(*$2, (decafAST *)$1, (decafAST *)$3);
-        $$ = b;
-    }
+    { $$ = tree.BinaryExpr($2, $1, $3); }
     | expr T_LEFTSHIFT expr
-    {
-        BinaryExpr *b;
-        b = new BinaryExpr(*$2, (decafAST *)$1, (decafAST *)$3);
-        $$ = b;
-    }
+    { $$ = tree.BinaryExpr($2, $1, $3); }
     | expr T_RIGHTSHIFT expr
-    {
-        BinaryExpr *b;
-        b = new BinaryExpr(*$2, (decafAST *)$1, (decafAST *)$3);
-        $$ = b;
-    }
+    { $$ = tree.BinaryExpr($2, $1, $3); }
     | expr T_MOD expr
-    {
-        BinaryExpr *b;
-        b = new BinaryExpr(*$2, (decafAST *)$1, (decafAST *)$3);
-        $$ = b;
-    }
+    { $$ = tree.BinaryExpr($2, $1, $3); }
     | expr T_EQ expr
-    {
-        BinaryExpr *b;
-        b = new BinaryExpr(*$2, (decafAST *)$1, (decafAST *)$3);
-        $$ = b;
-    }
+    { $$ = tree.BinaryExpr($2, $1, $3); }
     | expr T_NEQ expr
-    {
-        BinaryExpr *b;
-        b = new BinaryExpr(*$2, (decafAST *)$1, (decafAST *)$3);
-        $$ = b;
-    }
+    { $$ = tree.BinaryExpr($2, $1, $3); }
     | expr T_LT expr
-    {
-        BinaryExpr *b;
-        b = new BinaryExpr(*$2, (decafAST *)$1, (decafAST *)$3);
-        $$ = b;
-    }
+    { $$ = tree.BinaryExpr($2, $1, $3); }
     | expr T_LEQ expr
-    {
-        BinaryExpr *b;
-        b = new BinaryExpr(*$2, (decafAST *)$1, (decafAST *)$3);
-        $$ = b;
-    }
+    { $$ = tree.BinaryExpr($2, $1, $3); }
     | expr T_GT expr
-    {
-        BinaryExpr *b;
-        b = new BinaryExpr(*$2, (decafAST *)$1, (decafAST *)$3);
-        $$ = b;
-    }
+    { $$ = tree.BinaryExpr($2, $1, $3); }
     | expr T_GEQ expr
-    {
-        BinaryExpr *b;
-        b = new BinaryExpr(*$2, (decafAST *)$1, (decafAST *)$3);
-        $$ = b;
-    }
+    { $$ = tree.BinaryExpr($2, $1, $3); }
     | expr T_AND expr
-    {
-        BinaryExpr *b;
-        b = new BinaryExpr(*$2, (decafAST *)$1, (decafAST *)$3);
-        $$ = b;
-    }
+    { $$ = tree.BinaryExpr($2, $1, $3); }
     | expr T_OR expr
-    {
-        BinaryExpr *b;
-        b = new BinaryExpr(*$2, (decafAST *)$1, (decafAST *)$3);
-        $$ = b;
-    }
+    { $$ = tree.BinaryExpr($2, $1, $3); }
     | T_NOT expr %prec T_MOD
-    {
-        UnaryExpr *u;
-        u = new UnaryExpr(*$1, (decafAST *)$2);
-        $$ = u;
-    }
+    { $$ = tree.UnaryExpr($1, $2); }
     | T_MINUS expr %prec T_MOD
-    {
-        UnaryExpr *u;
-        u = new UnaryExpr("UnaryMinus", (decafAST *)$2);
-        $$ = u;
-    }
+    { $$ = tree.UnaryExpr(UnaryMinus_kind, $2); }
     | T_LPAREN expr T_RPAREN
     {  $$ = $2; }
     | T_ID T_LSB expr T_RSB
     {
-        decafStr *id = new decafStr( string("ArrayLocExpr") + "(" + *$1 + getString((decafAST *)$3) + ")" );
-        $$ = id;
+        $$ = tree.ArrayLocExpr(*$1, $3);
+        delete $1;
     }
     ;
 
 constant: T_INTCONSTANT
     {
-        ConstantAST *c;
-        c = new ConstantAST(*$1, true);
-        $$ = c; 
+        $$ = tree.NumberExpr(itoi(*$1));
+        delete $1;
     }
     | T_CHARCONSTANT
     {
-        ConstantAST *c;
-        c = new ConstantAST(ctoi(*$1), true);
-        $$ = c; 
+        $$ = tree.NumberExpr(ctoi(*$1));
+        delete $1;
     }
     | T_TRUE
-    {
-        ConstantAST *c;
-        c = new ConstantAST(*$1, false);
-        $$ = c; 
-    }
+    { $$ = tree.BoolExpr($1); }
     | T_FALSE
-    {
-        ConstantAST *c;
-        c = new ConstantAST(*$1, false);
-        $$ = c; 
-    }
+    { $$ = tree.BoolExpr($1); }
     ;
 
 method_call: T_ID T_LPAREN method_arg_list T_RPAREN
     {
-        MethodCallAST *method;
-        method = new MethodCallAST(*$1, (decafStmtList *)$3);
-        $$ = method;
+        $$ = tree.MethodCall(*$1, $3);
+        delete $1; delete $3;
     }
     ;
 
@@ -513,29 +401,28 @@ method_arg: expr
     { $$ = $1; }
     | T_STRINGCONSTANT
     {
-        decafStr *e = new decafStr( string("StringConstant") + "(" + *$1 + ")" );
-        $$ = e;
+        $$ = tree.StringConstant(*$1);
+        delete $1;
     }
     ;
 
-method_arg_list: method_arg T_COMMA method_arg_list
+/* a trailing comma is allowed */
+method_arg_list: method_args
+    { $$ = $1; }
+    | method_args T_COMMA
+    { $$ = $1; }
+    |
+    { $$ = NULL; }
+    ;
+
+method_args: method_args T_COMMA method_arg
     {
-        decafStmtList* mlist;
-        decafAST *m = (decafAST *)$1;
-        mlist = (decafStmtList *)$3;
-        mlist->push_front(m);
-        $$ = mlist;
+        $$ = append($1, $3);
     }
     | method_arg
     {
-        decafStmtList* mlist;
-        mlist = new decafStmtList();
-        decafAST *m = (decafAST *)$1;
-        mlist->push_front(m);
-        $$ = mlist;
+        $$ = append(NULL, $1);
     }
-    | 
-    { $$ = NULL; }
     ;
 
 binary_operator: arithmetic_operator
@@ -581,68 +468,51 @@ boolean_operator: T_AND
 unary_operator: T_NOT
     { $$ = $1; }
     | T_MINUS
-    {
-        $$ = new string("UnaryMinus");
-    }
+    { $$ = UnaryMinus_kind; }
     ;
 
 assign: T_ID T_ASSIGN expr
     {
-        decafStr *id = new decafStr( string("AssignVar") + "(" + *$1 + "," + getString((decafAST *)$3) + ")" );
-        $$ = id;
+        $$ = tree.AssignVar(*$1, $3);
+        delete $1;
     }
     | T_ID T_LSB expr T_RSB T_ASSIGN expr
     {
-        decafStr *id = new decafStr( string("AssignArrayLoc") + "(" + *$1 + "," + getString((decafAST *)$3) + "," + getString((decafAST *)$6) + ")" );
-        $$ = id;
+        $$ = tree.AssignArrayLoc(*$1, $3, $6);
+        delete $1;
     }
     ;
 
-assign_list: assign T_COMMA assign_list
+assign_list: assign_list T_COMMA assign
     {
-        decafStmtList* alist;
-        decafAST *a = (decafAST *)$1;
-        alist = (decafStmtList *)$3;
-        alist->push_front(a);
-        $$ = alist;
+        $$ = append($1, $3);
     }
     | assign
     {
-        decafStmtList* alist;
-        alist = new decafStmtList();
-        decafAST *a = (decafAST *)$1;
-        alist->push_front(a);
-        $$ = alist;
+        $$ = append(NULL, $1);
     }
     ;
 
 for_stmt: T_FOR T_LPAREN assign_list T_SEMICOLON expr T_SEMICOLON assign_list T_RPAREN block
     {
-        ForAST *for_s;
-        for_s = new ForAST((decafStmtList *)$3, (decafAST *)$5, (decafStmtList *)$7, (decafAST *)$9);
-        $$ = for_s;
+        $$ = tree.ForStmt($3, $5, $7, $9);
+        delete $3; delete $7;
     }
     ;
 
 if_stmt: T_IF T_LPAREN expr T_RPAREN block
     {
-        IfAST *if_s;
-        if_s = new IfAST((decafAST *)$3, (decafStmtList *)$5, new decafStmtList());
-        $$ = if_s;
+        $$ = tree.IfStmt($3, $5, ASDL_NONE);
     }
     | T_IF T_LPAREN expr T_RPAREN block T_ELSE block
     {
-        IfAST *if_s;
-        if_s = new IfAST((decafAST *)$3, (decafStmtList *)$5, new decafStmtList());
-        $$ = if_s;
+        $$ = tree.IfStmt($3, $5, $7);
     }
     ;
 
 while_stmt: T_WHILE T_LPAREN expr T_RPAREN block
     {
-        WhileAST *while_s;
-        while_s = new WhileAST((decafAST *)$3, (decafStmtList *)$5);
-        $$ = while_s;
+        $$ = tree.WhileStmt($3, $5);
     }
     ;
 
@@ -650,29 +520,96 @@ while_stmt: T_WHILE T_LPAREN expr T_RPAREN block
 
 return_stmt: T_RETURN T_SEMICOLON
     {
-        ReturnAST *return_s;
-        return_s = new ReturnAST(NULL);
-        $$ = return_s;
+        $$ = tree.ReturnStmt(ASDL_NONE);
     }
     | T_RETURN T_LPAREN T_RPAREN T_SEMICOLON
     {
-        ReturnAST *return_s;
-        return_s = new ReturnAST(NULL);
-        $$ = return_s;
+        $$ = tree.ReturnStmt(ASDL_NONE);
     }
     | T_RETURN T_LPAREN expr T_RPAREN T_SEMICOLON
     {
-        ReturnAST *return_s;
-        return_s = new ReturnAST((decafStmtList *)$3);
-        $$ = return_s;
+        $$ = tree.ReturnStmt($3);
     }
     ;
 
 %%
 
-int main() {
-  // parse the input and create the abstract syntax tree
-  int retval = yyparse();
-  return(retval >= 1 ? EXIT_FAILURE : EXIT_SUCCESS);
+// read a pickle written by -p into tree
+static bool load_tree(decaf_tree &tree, const char *path) {
+  int fd = open(path, O_RDONLY);
+  decaf_input in;
+  if (fd < 0 || !decaf_read_input(fd, &in)) {
+    perror(path);
+    return false;
+  }
+  close(fd);
+  bool ok = tree.load(in.base, in.len);
+  decaf_release_input(&in);
+  if (!ok) {
+    cerr << path << ": not an AST pickle for this version of decafast" << endl;
+  }
+  return ok;
 }
 
+static bool save_tree(const decaf_tree &tree, const char *path) {
+  FILE *fp = fopen(path, "wb");
+  if (fp == NULL || !tree.save(fp) || fclose(fp) != 0) {
+    perror(path);
+    return false;
+  }
+  return true;
+}
+
+int main(int argc, char **argv) {
+  // decafast [-i] [-p pickle | -l pickle] [file]
+  //   -i  print the AST indented
+  //   -p  also save the parsed AST to pickle
+  //   -l  load the AST from pickle instead of parsing the source
+  decaf_tree tree;
+  const char *save_path = NULL;
+  const char *load_path = NULL;
+  int arg = 1;
+  for (; arg < argc && argv[arg][0] == '-' && argv[arg][1] != '\0'; arg++) {
+    if (strcmp(argv[arg], "-i") == 0) {
+      indentAST = true;
+    } else if (strcmp(argv[arg], "-p") == 0 && arg + 1 < argc) {
+      save_path = argv[++arg];
+    } else if (strcmp(argv[arg], "-l") == 0 && arg + 1 < argc) {
+      load_path = argv[++arg];
+    } else {
+      cerr << "usage: decafast [-i] [-p pickle | -l pickle] [file]" << endl;
+      return EXIT_FAILURE;
+    }
+  }
+  if (load_path != NULL) {
+    if (!load_tree(tree, load_path)) {
+      return EXIT_FAILURE;
+    }
+  } else {
+    // map the source file (or stdin) so the lexer scans it in place
+    yyscan_t scanner = decaf_scan_begin(arg < argc ? argv[arg] : NULL);
+    if (scanner == NULL) {
+      return EXIT_FAILURE;
+    }
+    // parse the input and create the abstract syntax tree
+    int retval = yyparse(scanner, tree);
+    decaf_scan_end(scanner);
+    if (retval >= 1) {
+      return EXIT_FAILURE;
+    }
+    if (save_path != NULL && !save_tree(tree, save_path)) {
+      return EXIT_FAILURE;
+    }
+  }
+  if (printAST) {
+    if (indentAST) {
+      decaf_indent_buf indented(cout.rdbuf());
+      ostream out(&indented);
+      printTree(out, tree);
+    } else {
+      printTree(cout, tree);
+    }
+    cout.flush();
+  }
+  return EXIT_SUCCESS;
+}
@@ -9,23 +9,22 @@
 #include <stdexcept>
 #include <vector>
 
-
-extern int lineno;
-extern int tokenpos;
-
 using namespace std;
 
-extern "C"
-{
-	extern int yyerror(const char *);
-	int yyparse(void);
-	int yylex(void);  
-	int yywrap(void);
-}
+// the reentrant flex scanner of decafast.lex
+#ifndef YY_TYPEDEF_YY_SCANNER_T
+#define YY_TYPEDEF_YY_SCANNER_T
+typedef void *yyscan_t;
+#endif
+
+// defined in the lexer: a scanner for the whole file (stdin if NULL),
+// scanned in place. NULL if the file cannot be read.
+extern yyscan_t decaf_scan_begin(const char *path);
+extern void decaf_scan_end(yyscan_t scanner);
 
 typedef struct array {
-    std::string* size;
-    std::string* type;
+    int size;
+    int type;
     } arr;
 
 #endif
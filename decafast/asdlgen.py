@@ -0,0 +1,278 @@
+"""
+Run:
+
+    python asdlgen.py -o answer/decafast-asdl.h Decaf.asdl
+
+This reads an ASDL module and writes a C++ header with one compact node
+kind per constructor, field tables and typed constructor methods for
+the tree storage and pickle format in `answer/asdl.h`.
+
+To customize, run:
+
+    python asdlgen.py -h
+
+The ASDL dialect is the one used by `Decaf.asdl`:
+
+* an alternative that names another type includes all of its
+  constructors, e.g. `method_type = VoidType | decaf_type`
+* a field type that is not a type of the module is a nullary
+  constructor, e.g. `VarDef(StringType)`
+* alternatives of one type with the same constructor name are merged
+  and their field types are unioned, so `extern_type` has a single
+  `VarDef` whose field is `StringType`, `IntType` or `BoolType`
+
+A type whose constructors are all nullary is a simple sum: its values
+are stored inline as constructor kinds and no node is allocated.
+"""
+import sys, os, re, optparse
+
+builtin_types = {'identifier': 'ASDL_IDENT', 'string': 'ASDL_STRING', 'int': 'ASDL_INT'}
+
+class Field:
+    def __init__(self, type, opt, seq, name):
+        self.type = type    # a module type, a builtin, or a list of alternatives after merging
+        self.opt = opt
+        self.seq = seq
+        self.name = name
+
+class Ctor:
+    def __init__(self, name, fields):
+        self.name = name
+        self.fields = fields
+        self.cname = name   # name used in C++, prefixed by the type when reused
+        self.kind = None
+
+def tokenize(text):
+    text = re.sub(r'--.*', '', text)
+    return re.findall(r'[A-Za-z_][A-Za-z_0-9]*|[=|(),*?{}]', text)
+
+class Parser:
+    def __init__(self, tokens):
+        self.tokens = tokens
+        self.pos = 0
+
+    def peek(self):
+        return self.tokens[self.pos] if self.pos < len(self.tokens) else None
+
+    def next(self, expect=None):
+        tok = self.peek()
+        if tok is None or (expect is not None and tok != expect):
+            raise SyntaxError("expected {0} but found {1}".format(expect or "a name", tok))
+        self.pos += 1
+        return tok
+
+    def module(self):
+        self.next('module')
+        name = self.next()
+        self.next('{')
+        types = []
+        while self.peek() != '}':
+            types.append(self.definition())
+        self.next('}')
+        return name, types
+
+    def definition(self):
+        name = self.next()
+        self.next('=')
+        alts = [self.alternative()]
+        while self.peek() == '|':
+            self.next('|')
+            alts.append(self.alternative())
+        return name, alts
+
+    def alternative(self):
+        name = self.next()
+        fields = None
+        if self.peek() == '(':
+            self.next('(')
+            fields = [self.field()]
+            while self.peek() == ',':
+                self.next(',')
+                fields.append(self.field())
+            self.next(')')
+        return name, fields
+
+    def field(self):
+        type = self.next()
+        opt = seq = False
+        if self.peek() == '?':
+            self.next('?')
+            opt = True
+        elif self.peek() == '*':
+            self.next('*')
+            seq = True
+        name = None
+        if self.peek() not in (',', ')'):
+            name = self.next()
+        return Field(type, opt, seq, name)
+
+class Module:
+    def __init__(self, name, defs):
+        self.name = name
+        self.defs = dict(defs)
+        self.order = [n for (n, _) in defs]
+        self.ctors = []          # every constructor in kind order
+        self.by_name = {}        # nullary constructors are shared between types
+        self.own = {}            # constructors written in each type
+        for tname in self.order:
+            self.own[tname] = self.collect(tname)
+        for c in self.ctors:
+            if sum(1 for d in self.ctors if d.name == c.name) > 1:
+                c.cname = c.owner + '_' + c.name
+        for (i, c) in enumerate(self.ctors):
+            c.kind = i
+
+    def nullary(self, name, owner):
+        if name not in self.by_name:
+            c = Ctor(name, [])
+            c.owner = owner
+            self.by_name[name] = c
+            self.ctors.append(c)
+        return self.by_name[name]
+
+    def collect(self, tname):
+        ctors = []
+        merged = {}
+        for (name, fields) in self.defs[tname]:
+            if fields is None:
+                if name not in self.defs:
+                    ctors.append(self.nullary(name, tname))
+                continue
+            if name in merged:
+                c = merged[name]
+                if len(c.fields) != len(fields):
+                    raise SyntaxError("{0}: {1} is defined with different fields".format(tname, name))
+                for (f, g) in zip(c.fields, fields):
+                    if not isinstance(f.type, list):
+                        f.type = [f.type]
+                    f.type.append(g.type)
+                continue
+            c = Ctor(name, fields)
+            c.owner = tname
+            merged[name] = c
+            ctors.append(c)
+            self.ctors.append(c)
+        for c in merged.values():
+            for (i, f) in enumerate(c.fields):
+                if f.name is None:
+                    f.name = 'arg{0}'.format(i)
+                for t in (f.type if isinstance(f.type, list) else [f.type]):
+                    if t not in self.defs and t not in builtin_types:
+                        self.nullary(t, tname)
+        return ctors
+
+    def expand(self, tname, seen=None):
+        "all constructors a value of type tname can have"
+        if tname not in self.defs:
+            return [self.by_name[tname]]
+        seen = seen if seen is not None else set()
+        if tname in seen:
+            return []
+        seen.add(tname)
+        result = list(self.own[tname])
+        for (name, fields) in self.defs[tname]:
+            if fields is None and name in self.defs:
+                result += self.expand(name, seen)
+        return result
+
+    def field_type(self, f):
+        types = f.type if isinstance(f.type, list) else [f.type]
+        if len(types) == 1 and types[0] in builtin_types:
+            base = builtin_types[types[0]]
+        else:
+            ctors = []
+            for t in types:
+                if t in builtin_types:
+                    raise SyntaxError("{0}: cannot mix {1} with constructors".format(f.name, t))
+                ctors += self.expand(t)
+            base = 'ASDL_ENUM' if all(not c.fields for c in ctors) else 'ASDL_NODE'
+        if f.opt:
+            return base + '|ASDL_OPT'
+        if f.seq:
+            return base + '|ASDL_SEQ'
+        return base
+
+def fnv1a(text):
+    h = 0x811c9dc5
+    for b in text.encode('ascii'):
+        h = ((h ^ b) * 0x01000193) & 0xffffffff
+    return h
+
+def argument(prefix, ftype, name):
+    if ftype == 'ASDL_ENUM':
+        return prefix + '_kind ' + name
+    if ftype.endswith('ASDL_SEQ'):
+        return 'const asdl_seq *' + name
+    if ftype.startswith('ASDL_IDENT') or ftype.startswith('ASDL_STRING'):
+        return 'const string &' + name
+    if ftype == 'ASDL_INT':
+        return 'int32_t ' + name
+    return 'asdl_ref ' + name
+
+def store(ftype, name):
+    if ftype.endswith('ASDL_SEQ'):
+        return 'seq({0})'.format(name)
+    if ftype.startswith('ASDL_IDENT') or ftype.startswith('ASDL_STRING'):
+        return 'intern({0})'.format(name)
+    if ftype == 'ASDL_INT':
+        return '(uint32_t){0}'.format(name)
+    return name
+
+def generate(mod, source, out):
+    prefix = mod.name.lower()
+    guard = '_' + prefix.upper() + '_ASDL'
+    ftypes = dict((c.kind, [mod.field_type(f) for f in c.fields]) for c in mod.ctors)
+    schema = ';'.join(c.name + '(' + ','.join(ftypes[c.kind]) + ')' for c in mod.ctors)
+    w = out.write
+    w("// generated by asdlgen.py from {0}, do not edit\n\n".format(os.path.basename(source)))
+    w("#ifndef {0}\n#define {0}\n\n#include \"asdl.h\"\n\n".format(guard))
+    w("// one kind per constructor, the first word of its nodes\n")
+    w("enum {0}_kind {{\n".format(prefix))
+    for c in mod.ctors:
+        w("  {0}_kind,\n".format(c.cname))
+    w("  {0}_num_kinds\n}};\n\n".format(prefix))
+    w("// word offsets of the fields within a node\n")
+    w("enum {0}_field {{\n".format(prefix))
+    rows = []
+    for c in mod.ctors:
+        for (i, f) in enumerate(c.fields):
+            rows.append("  {0}_{1} = {2}".format(c.cname, f.name, i + 1))
+    w(",\n".join(rows) + "\n};\n\n")
+    for c in mod.ctors:
+        if c.fields:
+            w("static const unsigned char {0}_fields[] = {{ {1} }};\n".format(c.cname, ', '.join(ftypes[c.kind])))
+    w("\nstatic const asdl_ctor_info {0}_ctors[] = {{\n".format(prefix))
+    for c in mod.ctors:
+        w("  {{ \"{0}\", {1}, {2} }},\n".format(c.name, len(c.fields), c.cname + '_fields' if c.fields else 'NULL'))
+    w("};\n\n")
+    w("static const asdl_schema {0}_schema = {{ \"{1}\", 0x{2:08x}, {0}_num_kinds, {0}_ctors }};\n\n".format(prefix, mod.name, fnv1a(schema)))
+    w("// {0}_tree - an asdl_tree with one constructor method per node kind\n".format(prefix))
+    w("class {0}_tree : public asdl_tree {{\npublic:\n".format(prefix))
+    w("  {0}_tree() : asdl_tree(&{0}_schema) {{}}\n".format(prefix))
+    for c in mod.ctors:
+        if not c.fields:
+            if not all(not d.fields for d in mod.expand(c.owner)):
+                w("  asdl_ref {0}() {{ return alloc({0}_kind); }}\n".format(c.cname))
+            continue
+        args = ', '.join(argument(prefix, t, f.name) for (t, f) in zip(ftypes[c.kind], c.fields))
+        w("  asdl_ref {0}({1}) {{\n".format(c.cname, args))
+        w("    asdl_ref n = alloc({0}_kind);\n".format(c.cname))
+        for (t, f) in zip(ftypes[c.kind], c.fields):
+            w("    words[n + {0}_{1}] = {2};\n".format(c.cname, f.name, store(t, f.name)))
+        w("    return n;\n  }\n")
+    w("};\n\n#endif\n")
+
+if __name__ == '__main__':
+    optparser = optparse.OptionParser(usage="%prog [-o header] module.asdl")
+    optparser.add_option("-o", "--output", dest="output", default=None, help="header file to write (default: stdout)")
+    (opts, args) = optparser.parse_args()
+    if len(args) != 1:
+        optparser.error("expected one ASDL file")
+    with open(args[0]) as f:
+        name, defs = Parser(tokenize(f.read())).module()
+    mod = Module(name, defs)
+    if opts.output is None:
+        generate(mod, args[0], sys.stdout)
+    else:
+        with open(opts.output, 'w') as out:
+            generate(mod, args[0], out)
@@ -0,0 +1,165 @@
+
+#ifndef _DECAF_DEBUG
+#define _DECAF_DEBUG
+
+#include "llvm/BinaryFormat/Dwarf.h"
+#include "llvm/IR/DIBuilder.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/FileSystem.h"
+#include <string>
+#include <vector>
+
+// decaf_debug - DWARF debug information for decafcomp -g, so that perf,
+// gdb and the like map the generated code back to Decaf source lines.
+// The source file is the compile unit, each method a subprogram and
+// each nested block a lexical block, and the parameters, locals and
+// globals are described with their types.
+//
+// Code generation calls at() with the line and column of each statement
+// before generating it, and every instruction the IRBuilder makes then
+// carries that location. The variables are described with dbg.declare
+// on their allocas, which mem2reg turns into dbg.value when -O promotes
+// them to registers. Nothing is emitted unless enabled is set.
+class decaf_debug {
+  llvm::DIBuilder *builder;
+  llvm::DIFile *file;
+  bool optimized;
+  std::vector<llvm::DIScope *> scopes;   // innermost last, empty outside methods
+
+  llvm::DIType *type(llvm::Type *t) {
+    if (t->isIntegerTy(1)) {
+      return builder->createBasicType("bool", 8, llvm::dwarf::DW_ATE_boolean);
+    }
+    if (t->isIntegerTy()) {
+      return builder->createBasicType("int", 32, llvm::dwarf::DW_ATE_signed);
+    }
+    if (t->isArrayTy()) {
+      llvm::DIType *element = type(t->getArrayElementType());
+      uint64_t count = t->getArrayNumElements();
+      llvm::Metadata *range = builder->getOrCreateSubrange(0, count);
+      return builder->createArrayType(count * element->getSizeInBits(), 32, element, builder->getOrCreateArray(range));
+    }
+    if (t->isPointerTy()) {   // string
+      llvm::DIType *c = builder->createBasicType("char", 8, llvm::dwarf::DW_ATE_signed_char);
+      return builder->createPointerType(c, 64);
+    }
+    return NULL;   // void
+  }
+
+  void declare(llvm::IRBuilder<> &b, llvm::AllocaInst *alloca, llvm::DILocalVariable *var, int line) {
+    llvm::DILocation *loc = llvm::DILocation::get(b.getContext(), line, 0, scopes.back());
+    builder->insertDeclare(alloca, var, builder->createExpression(), loc, b.GetInsertBlock());
+  }
+
+public:
+  bool enabled;
+
+  decaf_debug() : builder(NULL), file(NULL), optimized(false), enabled(false) {}
+
+  // the compile unit for the source at path, stdin if NULL
+  void begin(llvm::Module *module, const char *path, bool optimize) {
+    if (!enabled) {
+      return;
+    }
+    llvm::SmallString<256> dir;
+    llvm::sys::fs::current_path(dir);
+    std::string name = path == NULL ? "<stdin>" : path;
+    optimized = optimize;
+    builder = new llvm::DIBuilder(*module);
+    file = builder->createFile(name, dir);
+    builder->createCompileUnit(llvm::dwarf::DW_LANG_C, file, "decafcomp", optimized, "", 0);
+    module->setSourceFileName(name);
+    module->addModuleFlag(llvm::Module::Warning, "Debug Info Version", llvm::DEBUG_METADATA_VERSION);
+    module->addModuleFlag(llvm::Module::Warning, "Dwarf Version", 4);
+  }
+  // resolve the types and variables, before the module is verified.
+  // The DIBuilder refers to the LLVMContext, so this also has to run
+  // before the context goes.
+  void finish() {
+    if (builder != NULL) {
+      builder->finalize();
+      delete builder;
+      builder = NULL;
+    }
+  }
+
+  // a method defined at line
+  void function(llvm::Function *func, int line) {
+    if (!enabled) {
+      return;
+    }
+    llvm::SmallVector<llvm::Metadata *, 8> types;
+    types.push_back(type(func->getReturnType()));
+    for (llvm::Argument &arg : func->args()) {
+      types.push_back(type(arg.getType()));
+    }
+    llvm::DISubroutineType *signature = builder->createSubroutineType(builder->getOrCreateTypeArray(types));
+    llvm::DISubprogram::DISPFlags flags = llvm::DISubprogram::SPFlagDefinition;
+    if (optimized) {
+      flags |= llvm::DISubprogram::SPFlagOptimized;
+    }
+    func->setSubprogram(builder->createFunction(file, func->getName(), "", file, line, signature, line,
+                                                llvm::DINode::FlagPrototyped, flags));
+  }
+  // a global variable declared at line
+  void global(llvm::GlobalVariable *var, int line) {
+    if (!enabled) {
+      return;
+    }
+    llvm::DIGlobalVariableExpression *e = builder->createGlobalVariableExpression(
+      file, var->getName(), "", file, line, type(var->getValueType()), var->hasInternalLinkage());
+    var->addDebugInfo(e);
+  }
+
+  // generate code into func, starting at its first line
+  void enter(llvm::IRBuilder<> &b, llvm::Function *func) {
+    if (!enabled) {
+      return;
+    }
+    llvm::DISubprogram *sp = func->getSubprogram();
+    scopes.push_back(sp);
+    at(b, sp->getLine(), 0);
+  }
+  void leave(llvm::IRBuilder<> &b) {
+    if (!enabled) {
+      return;
+    }
+    scopes.pop_back();
+    b.SetCurrentDebugLocation(llvm::DebugLoc());
+  }
+  // a block nested in the current scope, starting at line and column
+  void enterBlock(int line, int column) {
+    if (enabled) {
+      scopes.push_back(builder->createLexicalBlock(scopes.back(), file, line, column));
+    }
+  }
+  void leaveBlock() {
+    if (enabled) {
+      scopes.pop_back();
+    }
+  }
+  // the instructions made next come from line and column; line 0 keeps
+  // the current location, for the nodes that have none
+  void at(llvm::IRBuilder<> &b, int line, int column) {
+    if (enabled && line > 0 && !scopes.empty()) {
+      b.SetCurrentDebugLocation(llvm::DILocation::get(b.getContext(), line, column, scopes.back()));
+    }
+  }
+
+  // describe alloca as parameter number argno (from 1) or as a local
+  void parameter(llvm::IRBuilder<> &b, llvm::AllocaInst *alloca, const std::string &name, int argno, int line) {
+    if (enabled) {
+      declare(b, alloca, builder->createParameterVariable(scopes.back(), name, argno, file, line,
+                                                          type(alloca->getAllocatedType()), true), line);
+    }
+  }
+  void local(llvm::IRBuilder<> &b, llvm::AllocaInst *alloca, const std::string &name, int line) {
+    if (enabled) {
+      declare(b, alloca, builder->createAutoVariable(scopes.back(), name, file, line,
+                                                     type(alloca->getAllocatedType()), true), line);
+    }
+  }
+};
+
+#endif
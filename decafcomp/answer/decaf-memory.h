@@ -0,0 +1,225 @@
+
+#ifndef _DECAF_MEMORY
+#define _DECAF_MEMORY
+
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ostream>
+#include <string>
+#include <sys/resource.h>
+
+// decaf_memory - heap allocations of a compilation, for decafcomp -m.
+// In a build with -DDECAF_MEMORY_ACCOUNTING every operator new in the
+// process goes through allocate() (see decafcomp.cc), which puts the
+// size and category of the block in a header in front of it so that
+// release() can take it off the counts. Only the allocations made after
+// enabled is set are counted. Other builds allocate as usual and
+// decafcomp refuses -m.
+//
+// An allocation is charged to the innermost decaf_phase and to the
+// current category, which the compiler sets with a decaf_mem_category
+// scope: token strings in the lexer, AST nodes in the parser, the
+// symbol table, and LLVM for codegen, optimizing and printing. The
+// descriptors are members of the declaration nodes, so they count as
+// AST nodes.
+//
+// This runs inside operator new and before main, so it keeps its
+// counts in fixed arrays and never allocates itself. There is one for
+// the process, so only enable it when one compilation runs at a time.
+enum decaf_category {
+  MEM_OTHER, MEM_TOKENS, MEM_AST, MEM_SYMBOLS, MEM_LLVM, MEM_CATEGORIES
+};
+
+class decaf_memory {
+  static const size_t header_size = 16;   // keeps the blocks 16 byte aligned
+  struct header {
+    size_t size;
+    int category;                          // -1 if not counted
+  };
+  struct counts {
+    long allocs, frees;
+    size_t bytes, freed;
+  };
+  struct open_phase {
+    int row;                               // -1 if there was no room for it
+    long allocs;
+    size_t bytes;
+    size_t peak;                           // most bytes live while it ran
+  };
+  struct row {
+    const char *name;
+    int depth;
+    long count, allocs;
+    size_t bytes, peak;
+    long rss_kb;                           // peak RSS when it ended
+  };
+  static const int max_open = 16, max_rows = 32;
+
+  counts categories[MEM_CATEGORIES];
+  size_t live, peak;
+  open_phase open[max_open];
+  int nopen, depth;
+  row rows[max_rows];
+  int nrows;
+
+  static long rss_kb() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+  }
+
+public:
+  bool enabled;
+  int category;
+
+  void *allocate(size_t size) {
+    char *p = (char *)malloc(size + header_size);
+    if (p == NULL) {
+      return NULL;
+    }
+    header *h = (header *)p;
+    h->size = size;
+    h->category = -1;
+    if (enabled) {
+      h->category = category;
+      categories[category].allocs++;
+      categories[category].bytes += size;
+      live += size;
+      if (live > peak) {
+        peak = live;
+      }
+      if (nopen > 0) {
+        open_phase &o = open[nopen - 1];
+        o.allocs++;
+        o.bytes += size;
+        if (live > o.peak) {
+          o.peak = live;
+        }
+      }
+    }
+    return p + header_size;
+  }
+  void release(void *q) {
+    if (q == NULL) {
+      return;
+    }
+    header *h = (header *)((char *)q - header_size);
+    if (h->category >= 0) {
+      categories[h->category].frees++;
+      categories[h->category].freed += h->size;
+      live -= h->size;
+    }
+    free(h);
+  }
+
+  // phases nest like decaf_timer's; one row per name and depth, in
+  // the order the phases first ran
+  void begin(const char *name) {
+    if (depth++ >= max_open) {
+      return;
+    }
+    int r = 0;
+    while (r < nrows && !(rows[r].depth == nopen && strcmp(rows[r].name, name) == 0)) {
+      r++;
+    }
+    if (r == nrows) {
+      if (nrows < max_rows) {
+        row n = { name, nopen, 0, 0, 0, 0, 0 };
+        rows[nrows++] = n;
+      } else {
+        r = -1;
+      }
+    }
+    open_phase o = { r, 0, 0, live };
+    open[nopen++] = o;
+  }
+  void end() {
+    if (--depth >= max_open) {
+      return;
+    }
+    open_phase o = open[--nopen];
+    if (nopen > 0) {
+      open_phase &parent = open[nopen - 1];
+      parent.allocs += o.allocs;
+      parent.bytes += o.bytes;
+      if (o.peak > parent.peak) {
+        parent.peak = o.peak;
+      }
+    }
+    if (o.row < 0) {
+      return;
+    }
+    row &r = rows[o.row];
+    r.count++;
+    r.allocs += o.allocs;
+    r.bytes += o.bytes;
+    if (o.peak > r.peak) {
+      r.peak = o.peak;
+    }
+    r.rss_kb = rss_kb();
+  }
+
+  void report(std::ostream &out) const {
+    static const char *names[MEM_CATEGORIES] = { "other", "token strings", "AST nodes", "symbol table", "LLVM" };
+    char line[160];
+    snprintf(line, sizeof(line), "%-28s %8s %10s %12s %14s %13s\n", "phase", "count", "allocs", "KB allocated", "peak live KB", "peak RSS KB");
+    out << line;
+    for (int r = 0; r < nrows; r++) {
+      std::string name = std::string(2 * rows[r].depth, ' ') + rows[r].name;
+      snprintf(line, sizeof(line), "%-28s %8ld %10ld %12.1f %14.1f %13ld\n", name.c_str(), rows[r].count, rows[r].allocs,
+               rows[r].bytes / 1024.0, rows[r].peak / 1024.0, rows[r].rss_kb);
+      out << line;
+      if (strcmp(rows[r].name, "parse") == 0) {
+        // lexing is not a phase of its own, its allocations are the token strings
+        name = std::string(2 * rows[r].depth + 2, ' ') + "lex";
+        snprintf(line, sizeof(line), "%-28s %8s %10ld %12.1f %14s %13s\n", name.c_str(), "-", categories[MEM_TOKENS].allocs,
+                 categories[MEM_TOKENS].bytes / 1024.0, "-", "-");
+        out << line;
+      }
+    }
+    snprintf(line, sizeof(line), "\n%-28s %8s %10s %12s %14s %13s\n", "category", "", "allocs", "KB allocated", "frees", "KB live");
+    out << line;
+    counts total = { 0, 0, 0, 0 };
+    for (int c = 0; c < MEM_CATEGORIES; c++) {
+      const counts &n = categories[c];
+      snprintf(line, sizeof(line), "%-28s %8s %10ld %12.1f %14ld %13.1f\n", names[c], "", n.allocs, n.bytes / 1024.0, n.frees,
+               (n.bytes - n.freed) / 1024.0);
+      out << line;
+      total.allocs += n.allocs;
+      total.bytes += n.bytes;
+      total.frees += n.frees;
+      total.freed += n.freed;
+    }
+    snprintf(line, sizeof(line), "%-28s %8s %10ld %12.1f %14ld %13.1f\n", "total", "", total.allocs, total.bytes / 1024.0, total.frees,
+             (total.bytes - total.freed) / 1024.0);
+    out << line;
+    snprintf(line, sizeof(line), "\npeak live %.1f KB, peak RSS %ld KB\n", peak / 1024.0, rss_kb());
+    out << line;
+  }
+};
+
+// zero-initialized, so it works for the allocations made before main
+extern decaf_memory memoryStats;
+
+// decaf_mem_category - charges the allocations in the enclosing scope
+// to category c. The category is left alone unless the counts are
+// enabled, so compilations on other threads do not write to it.
+class decaf_mem_category {
+  int saved;
+  bool set;
+public:
+  decaf_mem_category(int c) : saved(memoryStats.category), set(memoryStats.enabled) {
+    if (set) {
+      memoryStats.category = c;
+    }
+  }
+  ~decaf_mem_category() {
+    if (set) {
+      memoryStats.category = saved;
+    }
+  }
+};
+
+#endif
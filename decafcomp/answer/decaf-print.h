@@ -0,0 +1,110 @@
+
+#ifndef _DECAF_PRINT
+#define _DECAF_PRINT
+
+#include <streambuf>
+#include <vector>
+
+// decaf_indent_buf - a streambuf that pretty prints the sexp trees written
+// through it and passes the result on to another streambuf. It makes the
+// same layout decisions as indentrees.perl, one character at a time, so an
+// AST can be printed straight into it without building the flat string
+// first. The state kept is just the stack of open paren columns.
+//
+//   decaf_indent_buf ib(cout.rdbuf());
+//   ostream out(&ib);
+//   prog->print(out);
+//
+class decaf_indent_buf : public std::streambuf {
+  std::streambuf *dest;
+  int maxtrim;          // break before a '(' that starts past this column
+  std::vector<int> indent;
+  int col;              // column of the next character on the output line
+  bool printnl;         // false right after ")(", which never breaks
+  char prevchar;
+  bool closing;         // inside a run of ')' and ' '
+  int closed;           // number of ')' in that run
+
+  int pop() {
+    if (indent.empty()) {
+      return 0;
+    }
+    int i = indent.back();
+    indent.pop_back();
+    return i;
+  }
+  void put(char c) { dest->sputc(c); }
+  void spaces(int n) {
+    for (int i = 0; i < n; i++) {
+      put(' ');
+    }
+  }
+  // a run of ')' ends the output line and the next line starts at the
+  // column of the '(' matching the first of them
+  void close_run(int next) {
+    if (next == '(') {
+      printnl = false;
+    }
+    for (int i = 0; i < closed; i++) {
+      put(')');
+    }
+    put('\n');
+    col = pop();
+    spaces(col);
+    closing = false;
+  }
+  void end_line() {
+    put('\n');
+    indent.clear();
+    prevchar = '\0';
+  }
+
+protected:
+  int overflow(int c) {
+    if (c == traits_type::eof()) {
+      return traits_type::not_eof(c);
+    }
+    if (closing) {
+      if (c == ')') {
+        pop();
+        closed++;
+        return c;
+      }
+      if (c == ' ') {
+        return c;
+      }
+      close_run(c);
+    }
+    if (c == '\n') {
+      end_line();
+      return c;
+    }
+    if (c == ')' && prevchar != '\\') {
+      closing = true;
+      closed = 1;
+      return c;
+    }
+    if (c == '(' && prevchar != '\\') {
+      if (printnl && col > maxtrim) {
+        put('\n');
+        int i = pop();
+        indent.push_back(i);
+        spaces(i + 2);
+        col = i + 2;
+      }
+      indent.push_back(col);
+    }
+    printnl = true;
+    col++;
+    put(c);
+    prevchar = c;
+    return c;
+  }
+  int sync() { return dest->pubsync(); }
+
+public:
+  decaf_indent_buf(std::streambuf *d, int width = 40)
+    : dest(d), maxtrim(width), col(0), printnl(true), prevchar('\0'), closing(false), closed(0) {}
+};
+
+#endif
@@ -0,0 +1,89 @@
+
+#ifndef _DECAF_PROFILE
+#define _DECAF_PROFILE
+
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/DerivedTypes.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/GlobalVariable.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/Module.h"
+
+// decaf_profile - the instrumentation of decafcomp -p, a function level
+// profile of the generated program without perf or a sampling profiler.
+// Each method gets a record, the struct decaf_profile of decaf-stdlib.c,
+// and calls __decaf_profile_enter with it when it starts and
+// __decaf_profile_exit before each of its returns. The runtime counts
+// the calls and cycles of each method and of each caller -> callee edge,
+// and writes them out when the program exits.
+class decaf_profile {
+  llvm::StructType *record;
+  llvm::FunctionCallee enterHook, exitHook;
+
+  // the runtime, declared on the first method
+  void declare(llvm::Module *module) {
+    llvm::LLVMContext &ctx = module->getContext();
+    llvm::Type *i8ptr = llvm::Type::getInt8PtrTy(ctx);
+    llvm::Type *i64 = llvm::Type::getInt64Ty(ctx);
+    // name, calls, inclusive, exclusive, active, next, last
+    record = llvm::StructType::create(ctx, { i8ptr, i64, i64, i64, i64, i8ptr, i8ptr }, "decaf_profile");
+    llvm::FunctionType *hook = llvm::FunctionType::get(llvm::Type::getVoidTy(ctx), { record->getPointerTo() }, false);
+    enterHook = module->getOrInsertFunction("__decaf_profile_enter", hook);
+    exitHook = module->getOrInsertFunction("__decaf_profile_exit", hook);
+    for (llvm::FunctionCallee f : { enterHook, exitHook }) {
+      llvm::cast<llvm::Function>(f.getCallee())->addFnAttr(llvm::Attribute::NoUnwind);
+    }
+  }
+
+public:
+  bool enabled;
+
+  decaf_profile() : record(NULL), enabled(false) {}
+
+  // instrument func once its body has been generated
+  void method(llvm::Function *func) {
+    if (!enabled) {
+      return;
+    }
+    llvm::Module *module = func->getParent();
+    if (record == NULL) {
+      declare(module);
+    }
+    llvm::LLVMContext &ctx = module->getContext();
+    llvm::Constant *name = llvm::ConstantDataArray::getString(ctx, func->getName());
+    llvm::GlobalVariable *str = new llvm::GlobalVariable(*module, name->getType(), true, llvm::GlobalValue::PrivateLinkage,
+                                                         name, "profile.name." + func->getName());
+    str->setUnnamedAddr(llvm::GlobalValue::UnnamedAddr::Global);
+    llvm::Constant *fields[] = {
+      llvm::ConstantExpr::getPointerCast(str, llvm::Type::getInt8PtrTy(ctx)),
+      llvm::ConstantInt::get(llvm::Type::getInt64Ty(ctx), 0),
+      llvm::ConstantInt::get(llvm::Type::getInt64Ty(ctx), 0),
+      llvm::ConstantInt::get(llvm::Type::getInt64Ty(ctx), 0),
+      llvm::ConstantInt::get(llvm::Type::getInt64Ty(ctx), 0),
+      llvm::ConstantPointerNull::get(llvm::Type::getInt8PtrTy(ctx)),
+      llvm::ConstantPointerNull::get(llvm::Type::getInt8PtrTy(ctx)),
+    };
+    llvm::GlobalVariable *rec = new llvm::GlobalVariable(*module, record, false, llvm::GlobalValue::InternalLinkage,
+                                                         llvm::ConstantStruct::get(record, fields),
+                                                         "profile." + func->getName());
+
+    // enter after the allocas, so that mem2reg still finds them together
+    llvm::BasicBlock &entry = func->getEntryBlock();
+    llvm::BasicBlock::iterator start = entry.begin();
+    while (llvm::isa<llvm::AllocaInst>(*start)) {
+      ++start;
+    }
+    llvm::IRBuilder<> b(&entry, start);
+    b.SetCurrentDebugLocation(start->getDebugLoc());
+    b.CreateCall(enterHook, { rec });
+    for (llvm::BasicBlock &bb : *func) {
+      if (llvm::ReturnInst *ret = llvm::dyn_cast_or_null<llvm::ReturnInst>(bb.getTerminator())) {
+        b.SetInsertPoint(ret);
+        b.CreateCall(exitHook, { rec });
+      }
+    }
+  }
+};
+
+#endif
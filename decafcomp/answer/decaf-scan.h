@@ -0,0 +1,332 @@
+
+#ifndef _DECAF_SCAN
+#define _DECAF_SCAN
+
+#include <cstddef>
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// A hand-written scanner for the decaflex token set, used instead of the
+// flex DFA with decaflex -s and decafcomp -s. It returns the same token
+// numbers as decaflex.lex and fails on the same inputs with the same
+// messages; contrib/scandiff.sh checks this over all the testcases.
+//
+// Whitespace, identifier and digit runs are classified 32 (AVX2) or 16
+// (SSE2) bytes at a time; comments are ended with memchr. Vector loads
+// are only done while a whole vector fits before the end of the input,
+// the rest is scanned a byte at a time.
+
+enum decaf_token_kind {
+  DTOK_BOOLTYPE = 1, DTOK_BREAK, DTOK_CONTINUE, DTOK_ELSE, DTOK_EXTERN,
+  DTOK_FALSE, DTOK_FOR, DTOK_FUNC, DTOK_IF, DTOK_INTTYPE,
+  DTOK_NULL, DTOK_PACKAGE, DTOK_RETURN, DTOK_STRINGTYPE, DTOK_TRUE,
+  DTOK_VAR, DTOK_VOID, DTOK_WHILE, DTOK_PLUS, DTOK_MINUS,
+  DTOK_MULT, DTOK_DIV, DTOK_MOD, DTOK_LT, DTOK_LEQ,
+  DTOK_GT, DTOK_GEQ, DTOK_EQ, DTOK_NEQ, DTOK_AND,
+  DTOK_OR, DTOK_NOT, DTOK_LEFTSHIFT, DTOK_RIGHTSHIFT, DTOK_ASSIGN,
+  DTOK_SEMICOLON, DTOK_COMMA, DTOK_DOT, DTOK_LCB, DTOK_RCB,
+  DTOK_LPAREN, DTOK_RPAREN, DTOK_LSB, DTOK_RSB, DTOK_WHITESPACE,
+  DTOK_COMMENT, DTOK_INTCONSTANT, DTOK_CHARCONSTANT, DTOK_STRINGCONSTANT, DTOK_ID,
+  DTOK_ERROR = -1
+};
+
+typedef struct decaf_scanner {
+  const char *p;       // next input byte
+  const char *end;     // one past the last input byte
+  const char *text;    // the token just scanned
+  int len;
+  const char *error;   // message when decaf_scan returns DTOK_ERROR
+} decaf_scanner;
+
+static void decaf_scan_init(decaf_scanner *s, const char *base, size_t len)
+{
+  s->p = base;
+  s->end = base + len;
+  s->text = base;
+  s->len = 0;
+  s->error = NULL;
+}
+
+// character classes, one bit each
+enum {
+  DC_SPACE = 1, DC_DIGIT = 2, DC_ALPHA = 4, DC_HEX = 8
+};
+
+static unsigned char decaf_class(unsigned char c)
+{
+  if (c == ' ' || c == '\r' || (c >= '\a' && c <= '\v')) {   // \a \b \t \n \v, not \f
+    return DC_SPACE;
+  }
+  if (c >= '0' && c <= '9') {
+    return DC_DIGIT | DC_HEX;
+  }
+  if (((c | 0x20) >= 'a' && (c | 0x20) <= 'f')) {
+    return DC_ALPHA | DC_HEX;
+  }
+  if (((c | 0x20) >= 'g' && (c | 0x20) <= 'z') || c == '_') {
+    return DC_ALPHA;
+  }
+  return 0;
+}
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#if defined(__AVX2__)
+typedef __m256i decaf_vec;
+#define DV_WIDTH 32
+#define dv_load(p) _mm256_loadu_si256((const __m256i *)(p))
+#define dv_set1(c) _mm256_set1_epi8(c)
+#define dv_or(a, b) _mm256_or_si256(a, b)
+#define dv_sub(a, b) _mm256_sub_epi8(a, b)
+#define dv_eq(a, b) _mm256_cmpeq_epi8(a, b)
+#define dv_max(a, b) _mm256_max_epu8(a, b)
+#define dv_mask(a) (unsigned)_mm256_movemask_epi8(a)
+#else
+typedef __m128i decaf_vec;
+#define DV_WIDTH 16
+#define dv_load(p) _mm_loadu_si128((const __m128i *)(p))
+#define dv_set1(c) _mm_set1_epi8(c)
+#define dv_or(a, b) _mm_or_si128(a, b)
+#define dv_sub(a, b) _mm_sub_epi8(a, b)
+#define dv_eq(a, b) _mm_cmpeq_epi8(a, b)
+#define dv_max(a, b) _mm_max_epu8(a, b)
+#define dv_mask(a) ((unsigned)_mm_movemask_epi8(a) | 0xffff0000u)
+#endif
+
+// bytes of v in [lo, hi]: v - lo <= hi - lo as unsigned bytes
+static inline decaf_vec dv_range(decaf_vec v, char lo, char hi)
+{
+  decaf_vec lim = dv_set1(hi - lo);
+  return dv_eq(dv_max(dv_sub(v, dv_set1(lo)), lim), lim);
+}
+
+static inline decaf_vec dv_classify(decaf_vec v, int cls)
+{
+  switch (cls) {
+  case DC_SPACE:
+    return dv_or(dv_range(v, '\a', '\v'), dv_or(dv_eq(v, dv_set1('\r')), dv_eq(v, dv_set1(' '))));
+  case DC_DIGIT:
+    return dv_range(v, '0', '9');
+  case DC_HEX:
+    return dv_or(dv_range(v, '0', '9'), dv_range(dv_or(v, dv_set1(0x20)), 'a', 'f'));
+  default:   // identifier characters
+    return dv_or(dv_or(dv_range(v, '0', '9'), dv_eq(v, dv_set1('_'))),
+                 dv_range(dv_or(v, dv_set1(0x20)), 'a', 'z'));
+  }
+}
+#endif
+
+// end of the run of bytes from p on that are in class cls; DC_ALPHA
+// means identifier characters, letters, digits and '_'
+static const char *decaf_span(const char *p, const char *end, int cls)
+{
+#if defined(__AVX2__) || defined(__SSE2__)
+  while (end - p >= DV_WIDTH) {
+    unsigned in = dv_mask(dv_classify(dv_load(p), cls));
+    if (~in != 0) {
+      return p + __builtin_ctz(~in);
+    }
+    p += DV_WIDTH;
+  }
+#endif
+  int want = (cls == DC_ALPHA) ? (DC_ALPHA | DC_DIGIT) : cls;
+  while (p < end && (decaf_class(*p) & want)) {
+    p++;
+  }
+  return p;
+}
+
+// keywords are matched after the identifier run is known, a keyword
+// rule wins over the identifier rule only when the lengths are equal
+static int decaf_keyword(const char *s, int n)
+{
+  static const struct { const char *word; int token; } keywords[] = {
+    { "bool", DTOK_BOOLTYPE }, { "break", DTOK_BREAK }, { "continue", DTOK_CONTINUE },
+    { "else", DTOK_ELSE }, { "extern", DTOK_EXTERN }, { "false", DTOK_FALSE },
+    { "for", DTOK_FOR }, { "func", DTOK_FUNC }, { "if", DTOK_IF },
+    { "int", DTOK_INTTYPE }, { "null", DTOK_NULL }, { "package", DTOK_PACKAGE },
+    { "return", DTOK_RETURN }, { "string", DTOK_STRINGTYPE }, { "true", DTOK_TRUE },
+    { "var", DTOK_VAR }, { "void", DTOK_VOID }, { "while", DTOK_WHILE }
+  };
+  if (n < 2 || n > 8) {
+    return DTOK_ID;
+  }
+  for (size_t i = 0; i < sizeof(keywords) / sizeof(keywords[0]); i++) {
+    if (keywords[i].word[0] == s[0] && (int)strlen(keywords[i].word) == n
+        && memcmp(keywords[i].word, s, n) == 0) {
+      return keywords[i].token;
+    }
+  }
+  return DTOK_ID;
+}
+
+static bool decaf_escape(char c)
+{
+  return c != '\0' && strchr("abtnvfr\\'\"", c) != NULL;
+}
+
+// The quote rules in decaflex.lex overlap, and flex picks the longest
+// match (the earliest rule on a tie). For a char constant the items
+// between the quotes parse one way only, so the longest match is
+// decided by what follows the greedy run of items.
+static int decaf_scan_char(decaf_scanner *s, const char *p)
+{
+  const char *q = p + 1;
+  int items = 0;
+  for (;;) {
+    if (q < s->end && *q != '\'' && *q != '\\' && *q != '\n') {
+      q++;
+    } else if (q + 1 < s->end && *q == '\\' && decaf_escape(q[1])) {
+      q += 2;
+    } else {
+      break;
+    }
+    items++;
+  }
+  if (q < s->end && *q == '\'') {
+    if (items == 1) {
+      s->len = q + 1 - p;
+      return DTOK_CHARCONSTANT;
+    }
+    s->error = items == 0 ? "Error: char constant has zero width"
+                          : "Error: char constant length is greater than one";
+  } else {
+    s->error = "Error: unterminated char constant";
+  }
+  return DTOK_ERROR;
+}
+
+// A string constant ends at the first quote not part of an escape. If
+// every escape is valid it is a token; if only some are, the unknown
+// escape rule matches. Otherwise the newline rule matches up to the
+// next quote anywhere, and failing that only the opening quote does.
+static int decaf_scan_string(decaf_scanner *s, const char *p)
+{
+  const char *q = p + 1;
+  bool valid = true;
+  while (q < s->end && *q != '"' && *q != '\n') {
+    if (*q == '\\') {
+      if (q + 1 >= s->end || q[1] == '\n') {
+        break;
+      }
+      valid = valid && decaf_escape(q[1]);
+      q += 2;
+    } else {
+      q++;
+    }
+  }
+  if (q < s->end && *q == '"') {
+    if (valid) {
+      s->len = q + 1 - p;
+      return DTOK_STRINGCONSTANT;
+    }
+    s->error = "Error: unknown escape sequence in string constant";
+  } else if (memchr(p + 1, '"', s->end - p - 1) != NULL) {
+    s->error = "Error: newline in string constant";
+  } else {
+    s->error = "Error: string constant is missing closing delimiter";
+  }
+  return DTOK_ERROR;
+}
+
+// scan the next token: its number, 0 at the end of the input, or
+// DTOK_ERROR with s->error set. s->text and s->len give the lexeme.
+static int decaf_scan(decaf_scanner *s)
+{
+  const char *p = s->p;
+  const char *end = s->end;
+  if (p >= end) {
+    return 0;
+  }
+  s->text = p;
+  s->len = 1;
+  s->error = NULL;
+  int token;
+  unsigned char c = *p;
+  char next = (p + 1 < end) ? p[1] : '\0';
+  unsigned char cls = decaf_class(c);
+  if (cls & DC_SPACE) {
+    s->len = decaf_span(p, end, DC_SPACE) - p;
+    token = DTOK_WHITESPACE;
+  } else if (cls & DC_DIGIT) {
+    const char *q = decaf_span(p, end, DC_DIGIT);
+    if (c == '0' && (next == 'x' || next == 'X') && p + 2 < end && (decaf_class(p[2]) & DC_HEX)) {
+      q = decaf_span(p + 2, end, DC_HEX);
+    }
+    s->len = q - p;
+    token = DTOK_INTCONSTANT;
+  } else if (cls & DC_ALPHA) {
+    s->len = decaf_span(p, end, DC_ALPHA) - p;
+    token = decaf_keyword(p, s->len);
+  } else {
+    switch (c) {
+    case '/':
+      if (next == '/') {
+        const char *nl = (const char *)memchr(p + 2, '\n', end - p - 2);
+        if (nl != NULL) {
+          s->len = nl + 1 - p;
+          token = DTOK_COMMENT;
+          break;
+        }
+      }
+      token = DTOK_DIV;
+      break;
+    case '+': token = DTOK_PLUS; break;
+    case '-': token = DTOK_MINUS; break;
+    case '*': token = DTOK_MULT; break;
+    case '%': token = DTOK_MOD; break;
+    case '<':
+      if (next == '=') { s->len = 2; token = DTOK_LEQ; }
+      else if (next == '<') { s->len = 2; token = DTOK_LEFTSHIFT; }
+      else { token = DTOK_LT; }
+      break;
+    case '>':
+      if (next == '=') { s->len = 2; token = DTOK_GEQ; }
+      else if (next == '>') { s->len = 2; token = DTOK_RIGHTSHIFT; }
+      else { token = DTOK_GT; }
+      break;
+    case '=':
+      if (next == '=') { s->len = 2; token = DTOK_EQ; }
+      else { token = DTOK_ASSIGN; }
+      break;
+    case '!':
+      if (next == '=') { s->len = 2; token = DTOK_NEQ; }
+      else { token = DTOK_NOT; }
+      break;
+    case '&':
+      if (next == '&') { s->len = 2; token = DTOK_AND; }
+      else { token = DTOK_ERROR; }
+      break;
+    case '|':
+      if (next == '|') { s->len = 2; token = DTOK_OR; }
+      else { token = DTOK_ERROR; }
+      break;
+    case ';': token = DTOK_SEMICOLON; break;
+    case ',': token = DTOK_COMMA; break;
+    case '.': token = DTOK_DOT; break;
+    case '{': token = DTOK_LCB; break;
+    case '}': token = DTOK_RCB; break;
+    case '(': token = DTOK_LPAREN; break;
+    case ')': token = DTOK_RPAREN; break;
+    case '[': token = DTOK_LSB; break;
+    case ']': token = DTOK_RSB; break;
+    case '\'': token = decaf_scan_char(s, p); break;
+    case '"': token = decaf_scan_string(s, p); break;
+    default: token = DTOK_ERROR; break;
+    }
+  }
+  if (token == DTOK_ERROR) {
+    if (s->error == NULL) {
+      s->error = "Error: unexpected character in input";
+    }
+    return token;
+  }
+  s->p = p + s->len;
+  return token;
+}
+
+#endif
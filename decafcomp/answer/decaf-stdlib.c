@@ -1,6 +1,12 @@
 
 
 #include <stdio.h>
+#include <stdlib.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <time.h>
+#endif
 
 void print_int(int x) {
   printf("%d", x);
@@ -16,3 +22,197 @@ int read_int() {
   return i;
 }
 
+
+/* The runtime of decafcomp -p, see decaf-profile.h. Each method passes
+   its record to __decaf_profile_enter and __decaf_profile_exit, which
+   keep a stack of the calls in progress. At exit the methods, sorted by
+   the cycles spent in their own code, and the caller -> callee edges,
+   sorted by cycles, are written to $DECAF_PROFILE or decaf-profile.txt.
+   The cycles are read with rdtsc where there is one. Inclusive cycles
+   only count the outermost call of a recursive method; the cycles of a
+   recursive edge do include its nested calls. */
+
+struct decaf_profile {
+  const char *name;
+  long long calls;
+  unsigned long long inclusive;  /* in the method and the methods it calls */
+  unsigned long long exclusive;  /* in the method itself */
+  long long active;              /* calls on the stack */
+  struct decaf_profile *next;    /* the methods called so far */
+  struct decaf_profile_edge *last;  /* the edge of its last call */
+};
+
+struct decaf_profile_edge {
+  struct decaf_profile *caller, *callee;
+  long long calls;
+  unsigned long long cycles;
+};
+
+struct decaf_profile_frame {
+  struct decaf_profile *method;
+  struct decaf_profile_edge *edge;  /* NULL for main */
+  unsigned long long start;
+  unsigned long long children;      /* cycles in the calls it made */
+};
+
+static struct decaf_profile *profile_methods;
+static struct decaf_profile_frame *profile_stack;
+static size_t profile_depth, profile_capacity;
+static struct decaf_profile_edge *profile_edges;  /* open addressing */
+static size_t profile_edge_count, profile_edge_capacity;
+
+static unsigned long long profile_clock(void) {
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec * 1000000000ULL + t.tv_nsec;
+#endif
+}
+
+static struct decaf_profile_edge *profile_slot(struct decaf_profile_edge *edges, size_t capacity,
+                                               struct decaf_profile *caller, struct decaf_profile *callee) {
+  size_t h = (((size_t)caller >> 4) * 31 + ((size_t)callee >> 4)) & (capacity - 1);
+  while (edges[h].callee != NULL && (edges[h].caller != caller || edges[h].callee != callee)) {
+    h = (h + 1) & (capacity - 1);
+  }
+  return &edges[h];
+}
+
+static struct decaf_profile_edge *profile_edge(struct decaf_profile *caller, struct decaf_profile *callee) {
+  struct decaf_profile_edge *e;
+  struct decaf_profile *m;
+  size_t i;
+  if (2 * (profile_edge_count + 1) > profile_edge_capacity) {
+    size_t capacity = profile_edge_capacity == 0 ? 256 : 2 * profile_edge_capacity;
+    struct decaf_profile_edge *edges = calloc(capacity, sizeof *edges);
+    for (i = 0; i < profile_edge_capacity; i++) {
+      if (profile_edges[i].callee != NULL) {
+        *profile_slot(edges, capacity, profile_edges[i].caller, profile_edges[i].callee) = profile_edges[i];
+      }
+    }
+    /* the frames and methods point into the old table */
+    for (m = profile_methods; m != NULL; m = m->next) {
+      m->last = NULL;
+    }
+    for (i = 0; i < profile_depth; i++) {
+      if (profile_stack[i].edge != NULL) {
+        profile_stack[i].edge = profile_slot(edges, capacity, profile_stack[i].edge->caller, profile_stack[i].edge->callee);
+      }
+    }
+    free(profile_edges);
+    profile_edges = edges;
+    profile_edge_capacity = capacity;
+  }
+  e = profile_slot(profile_edges, profile_edge_capacity, caller, callee);
+  if (e->callee == NULL) {
+    e->caller = caller;
+    e->callee = callee;
+    profile_edge_count++;
+  }
+  return e;
+}
+
+static int profile_by_exclusive(const void *a, const void *b) {
+  const struct decaf_profile *x = *(struct decaf_profile *const *)a, *y = *(struct decaf_profile *const *)b;
+  return x->exclusive < y->exclusive ? 1 : x->exclusive > y->exclusive ? -1 : 0;
+}
+
+static int profile_by_cycles(const void *a, const void *b) {
+  const struct decaf_profile_edge *x = a, *y = b;
+  return x->cycles < y->cycles ? 1 : x->cycles > y->cycles ? -1 : 0;
+}
+
+static void profile_write(void) {
+  const char *path = getenv("DECAF_PROFILE");
+  struct decaf_profile *m, **methods;
+  unsigned long long total = 0;
+  size_t n = 0, i, j;
+  FILE *out;
+  if (path == NULL) {
+    path = "decaf-profile.txt";
+  }
+  out = fopen(path, "w");
+  if (out == NULL) {
+    perror(path);
+    return;
+  }
+  for (m = profile_methods; m != NULL; m = m->next) {
+    n++;
+    total += m->exclusive;
+  }
+  methods = malloc((n + 1) * sizeof *methods);
+  for (i = 0, m = profile_methods; m != NULL; m = m->next) {
+    methods[i++] = m;
+  }
+  qsort(methods, n, sizeof *methods, profile_by_exclusive);
+  fprintf(out, "flat profile, %llu cycles\n", total);
+  fprintf(out, "  %%time    exclusive    inclusive       calls  method\n");
+  for (i = 0; i < n; i++) {
+    fprintf(out, "%7.2f %12llu %12llu %11lld  %s\n", total == 0 ? 0.0 : 100.0 * methods[i]->exclusive / total,
+            methods[i]->exclusive, methods[i]->inclusive, methods[i]->calls, methods[i]->name);
+  }
+  free(methods);
+
+  /* compact the edges to the front of the table and sort them */
+  for (i = j = 0; i < profile_edge_capacity; i++) {
+    if (profile_edges[i].callee != NULL) {
+      profile_edges[j++] = profile_edges[i];
+    }
+  }
+  qsort(profile_edges, j, sizeof *profile_edges, profile_by_cycles);
+  fprintf(out, "\ncall graph\n");
+  fprintf(out, "      calls       cycles  caller -> callee\n");
+  for (i = 0; i < j; i++) {
+    fprintf(out, "%11lld %12llu  %s -> %s\n", profile_edges[i].calls, profile_edges[i].cycles,
+            profile_edges[i].caller->name, profile_edges[i].callee->name);
+  }
+  fclose(out);
+}
+
+void __decaf_profile_enter(struct decaf_profile *method) {
+  struct decaf_profile_frame *f;
+  if (method->calls++ == 0) {
+    if (profile_methods == NULL) {
+      atexit(profile_write);
+    }
+    method->next = profile_methods;
+    profile_methods = method;
+  }
+  method->active++;
+  if (profile_depth == profile_capacity) {
+    profile_capacity = profile_capacity == 0 ? 1024 : 2 * profile_capacity;
+    profile_stack = realloc(profile_stack, profile_capacity * sizeof *profile_stack);
+  }
+  f = &profile_stack[profile_depth];
+  f->method = method;
+  f->edge = NULL;
+  if (profile_depth > 0) {
+    struct decaf_profile *caller = profile_stack[profile_depth - 1].method;
+    if (method->last == NULL || method->last->caller != caller) {
+      method->last = profile_edge(caller, method);
+    }
+    f->edge = method->last;
+    f->edge->calls++;
+  }
+  f->children = 0;
+  profile_depth++;
+  f->start = profile_clock();
+}
+
+void __decaf_profile_exit(struct decaf_profile *method) {
+  unsigned long long now = profile_clock();
+  struct decaf_profile_frame *f = &profile_stack[--profile_depth];
+  unsigned long long elapsed = now - f->start;
+  method->exclusive += elapsed - f->children;
+  if (--method->active == 0) {
+    method->inclusive += elapsed;
+  }
+  if (f->edge != NULL) {
+    f->edge->cycles += elapsed;
+  }
+  if (profile_depth > 0) {
+    profile_stack[profile_depth - 1].children += elapsed;
+  }
+}
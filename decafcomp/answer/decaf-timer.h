@@ -0,0 +1,163 @@
+
+#ifndef _DECAF_TIMER
+#define _DECAF_TIMER
+
+#include <cstdio>
+#include <ctime>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "decaf-memory.h"
+
+// decaf_timer - wall and CPU time of the phases of a compilation, for
+// decafcomp -t (a summary table) and -T (a Chrome trace_event file for
+// chrome://tracing or Perfetto). A phase is timed by a decaf_phase on
+// the stack, so phases nest. Nothing is recorded unless enabled is set.
+//
+// Lexing happens a token at a time inside the parse, so it is summed
+// up instead: its time is part of the parse phase and is also shown on
+// its own. Only its wall time is measured, reading the CPU clock for
+// every token would cost more than scanning the token.
+class decaf_timer {
+  struct span {
+    const char *name;
+    std::string detail;   // e.g. the method name
+    int depth;
+    double start;         // microseconds since the timer was created
+    double wall;
+    double cpu;
+  };
+  std::vector<span> spans;
+  std::vector<size_t> open;
+  double origin;
+
+  static void json_string(std::ostream &out, const std::string &s) {
+    out << '"';
+    for (size_t i = 0; i < s.size(); i++) {
+      unsigned char c = s[i];
+      if (c == '"' || c == '\\') {
+        out << '\\' << c;
+      } else if (c < 0x20) {
+        char buf[8];
+        snprintf(buf, sizeof(buf), "\\u%04x", c);
+        out << buf;
+      } else {
+        out << c;
+      }
+    }
+    out << '"';
+  }
+
+public:
+  bool enabled;
+  double lex_wall;
+  long lex_tokens;
+
+  static double wall_now() {
+    timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1e6 + t.tv_nsec / 1e3;
+  }
+  static double cpu_now() {
+    timespec t;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &t);
+    return t.tv_sec * 1e6 + t.tv_nsec / 1e3;
+  }
+
+  decaf_timer() : origin(wall_now()), enabled(false), lex_wall(0), lex_tokens(0) {}
+
+  void begin(const char *name, const std::string &detail) {
+    span s = { name, detail, (int)open.size(), wall_now() - origin, 0, cpu_now() };
+    open.push_back(spans.size());
+    spans.push_back(s);
+  }
+  void end() {
+    span &s = spans[open.back()];
+    open.pop_back();
+    s.wall = wall_now() - origin - s.start;
+    s.cpu = cpu_now() - s.cpu;
+  }
+  void count_lex(double start) {
+    lex_wall += wall_now() - start;
+    lex_tokens++;
+  }
+
+  // one row per phase name and depth, in the order the phases first
+  // ran, with the number of times it ran and its total time
+  void summary(std::ostream &out) const {
+    struct row { const char *name; int depth; long count; double wall, cpu; };
+    std::vector<row> rows;
+    for (size_t i = 0; i < spans.size(); i++) {
+      size_t r = 0;
+      while (r < rows.size() && !(rows[r].depth == spans[i].depth && std::string(rows[r].name) == spans[i].name)) {
+        r++;
+      }
+      if (r == rows.size()) {
+        row n = { spans[i].name, spans[i].depth, 0, 0, 0 };
+        rows.push_back(n);
+      }
+      rows[r].count++;
+      rows[r].wall += spans[i].wall;
+      rows[r].cpu += spans[i].cpu;
+    }
+    char line[128];
+    snprintf(line, sizeof(line), "%-28s %8s %12s %12s\n", "phase", "count", "wall ms", "cpu ms");
+    out << line;
+    for (size_t r = 0; r < rows.size(); r++) {
+      std::string name = std::string(2 * rows[r].depth, ' ') + rows[r].name;
+      snprintf(line, sizeof(line), "%-28s %8ld %12.3f %12.3f\n", name.c_str(), rows[r].count, rows[r].wall / 1e3, rows[r].cpu / 1e3);
+      out << line;
+      if (std::string(rows[r].name) == "parse" && lex_tokens > 0) {
+        name = std::string(2 * rows[r].depth + 2, ' ') + "lex";
+        snprintf(line, sizeof(line), "%-28s %8ld %12.3f %12s\n", name.c_str(), lex_tokens, lex_wall / 1e3, "-");
+        out << line;
+      }
+    }
+  }
+
+  // every phase as a complete ("X") event, times in microseconds
+  void trace(std::ostream &out) const {
+    out << "{\"traceEvents\":[";
+    for (size_t i = 0; i < spans.size(); i++) {
+      const span &s = spans[i];
+      char times[128];
+      snprintf(times, sizeof(times), "\"ts\":%.3f,\"dur\":%.3f,\"tdur\":%.3f", s.start, s.wall, s.cpu);
+      out << (i > 0 ? ",\n" : "\n") << "{\"name\":";
+      json_string(out, s.detail.empty() ? s.name : s.detail);
+      out << ",\"cat\":";
+      json_string(out, s.name);
+      out << ",\"ph\":\"X\",\"pid\":1,\"tid\":1," << times;
+      if (std::string(s.name) == "parse" && lex_tokens > 0) {
+        snprintf(times, sizeof(times), ",\"args\":{\"lex tokens\":%ld,\"lex ms\":%.3f}", lex_tokens, lex_wall / 1e3);
+        out << times;
+      }
+      out << "}";
+    }
+    out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+  }
+};
+
+// decaf_phase - times the enclosing scope as one phase of timer, and
+// counts its allocations for decafcomp -m
+class decaf_phase {
+  decaf_timer &timer;
+public:
+  decaf_phase(decaf_timer &t, const char *name, const std::string &detail = std::string()) : timer(t) {
+    if (timer.enabled) {
+      timer.begin(name, detail);
+    }
+    if (memoryStats.enabled) {
+      memoryStats.begin(name);
+    }
+  }
+  ~decaf_phase() {
+    if (memoryStats.enabled) {
+      memoryStats.end();
+    }
+    if (timer.enabled) {
+      timer.end();
+    }
+  }
+};
+
+#endif
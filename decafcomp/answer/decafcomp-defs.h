@@ -11,53 +11,168 @@
 #include <cstdio> 
 #include <cstdlib>
 #include <cstring> 
+#include <iostream>
 #include <string>
 #include <stdexcept>
+#include <unordered_map>
 #include <vector>
-
-extern int lineno;
-extern int tokenpos;
+#include "decaf-timer.h"
+#include "decaf-debug.h"
+#include "decaf-profile.h"
 
 using namespace std;
 
-extern "C"
-{
-	extern int yyerror(const char *);
-	int yyparse(void);
-	int yylex(void);  
-	int yywrap(void);
-}
+class decaf_compiler;
+
+// the reentrant flex scanner, see decafcomp.lex
+#ifndef YY_TYPEDEF_YY_SCANNER_T
+#define YY_TYPEDEF_YY_SCANNER_T
+typedef void *yyscan_t;
+#endif
+
+// defined in the lexer: a scanner for the whole file (stdin if NULL),
+// scanned in place, for the parse of compiler. NULL if the file cannot
+// be read.
+extern yyscan_t decaf_scan_begin(decaf_compiler &compiler, const char *path);
+extern void decaf_scan_end(yyscan_t scanner);
+
+// the results of decaf_compiler::compile
+const int DECAF_SYNTAX_ERROR = 1;
+const int DECAF_SEMANTIC_ERROR = 2;
+
+// operators and types travel from the lexer to codegen as small enums,
+// their ASDL names are only looked up when the AST is printed
+typedef enum decafOp {
+  OP_PLUS, OP_MINUS, OP_MULT, OP_DIV, OP_LEFTSHIFT, OP_RIGHTSHIFT, OP_MOD,
+  OP_LT, OP_GT, OP_LEQ, OP_GEQ, OP_EQ, OP_NEQ, OP_AND, OP_OR,
+  OP_UNARYMINUS, OP_NOT
+} decafOp;
+
+typedef enum decafType {
+  TYPE_INT, TYPE_BOOL, TYPE_VOID, TYPE_STRING
+} decafType;
 
 typedef struct array {
     std::string* size;
-    std::string* type;
+    decafType type;
     } arr;
 
+typedef enum descriptor_kind {
+  DESC_LOCAL, DESC_GLOBAL, DESC_FUNC
+} descriptor_kind;
+
+// what a name is bound to; kind says which pointer is valid.
+// Each declaration node owns its descriptor: the resolution pass points
+// the uses at it and codegen fills in the pointer.
 typedef struct descriptor 
 { 
   int lineno;
-  string type;
-  llvm::AllocaInst* alloca_ptr;
-  llvm::Function*     func_ptr;
-  vector<llvm::Type*> arg_types;
-  vector<string>      arg_names;
-  llvm::GlobalVariable *global_ptr;
-  llvm::BasicBlock *block_ptr;
+  descriptor_kind kind;
+  decafType type;
+  union {
+    llvm::AllocaInst*     alloca_ptr;
+    llvm::GlobalVariable* global_ptr;
+    llvm::Function*       func_ptr;
+  };
 }descriptor; 
 
-typedef map<string, descriptor*> symbol_table;
-
-typedef list<symbol_table> symbol_table_list;
-
-extern int lineno;
-
-extern int tokenpos;
-
-extern symbol_table_list symtbl;
-
-extern descriptor* access_symtbl(string id);
-
-extern void print_descriptor(string id);
+// identifiers are interned once, and the symbol table is keyed by the
+// resulting small integer instead of the string
+typedef int symbol_id;
+
+// symbol_table - scoped table indexed directly by interned id.
+// head[id] is the innermost binding of id, and each binding links to the
+// binding it shadows. A scope is just the number of bindings that existed
+// when it was entered, so lookup and enter_scope are O(1) and exit_scope
+// only touches the names the scope declared.
+class symbol_table {
+  struct binding {
+    symbol_id id;
+    descriptor *desc;
+    int shadowed;
+  };
+  vector<binding> bindings;
+  vector<int> head;
+  vector<int> scopes;
+public:
+  void enter_scope() {
+    decaf_mem_category symbols(MEM_SYMBOLS);
+    scopes.push_back(bindings.size());
+  }
+  void exit_scope() {
+    int mark = scopes.back();
+    scopes.pop_back();
+    while ((int)bindings.size() > mark) {
+      head[bindings.back().id] = bindings.back().shadowed;
+      bindings.pop_back();
+    }
+  }
+  void insert(symbol_id id, descriptor *d) {
+    decaf_mem_category symbols(MEM_SYMBOLS);
+    if (id >= (int)head.size()) {
+      head.resize(id + 1, -1);
+    }
+    binding b = { id, d, head[id] };
+    head[id] = bindings.size();
+    bindings.push_back(b);
+  }
+  descriptor *lookup(symbol_id id) {
+    if (id >= (int)head.size() || head[id] < 0) {
+      return NULL;
+    }
+    return bindings[head[id]].desc;
+  }
+};
+
+class ProgramAST;
+class LoopAST;
+struct method_effects;
+
+// decaf_compiler - one compilation and all the state it changes: the
+// LLVM context, module and IR builder, the symbol table, the interned
+// names and the options. Nothing else is global, so programs compiled
+// by different decaf_compilers can be compiled on different threads.
+//
+//   decaf_compiler compiler;
+//   compiler.optimizeIR = true;
+//   if (compiler.compile("prog.decaf") == 0) {
+//     compiler.module()->print(llvm::outs(), nullptr);
+//   }
+class decaf_compiler {
+  // interned identifier names, indexed by symbol_id
+  unordered_map<string, symbol_id> symbol_ids;
+  vector<string> symbol_names;
+public:
+  // options, set before compile()
+  bool printAST;          // print the AST on out after the parse
+  bool indentAST;         // print it indented instead of on one line
+  bool handScanner;       // take tokens from decaf-scan.h instead of flex
+  bool optimizeIR;        // optimize the module after codegen
+  ostream &out;           // the AST and semantic errors go here
+  decaf_timer timer;      // the phases, if timer.enabled
+  decaf_debug debug;      // DWARF for the module, if debug.enabled
+  decaf_profile profile;  // instrument the methods, if profile.enabled
+
+  llvm::LLVMContext TheContext;
+  llvm::IRBuilder<> Builder;
+  llvm::Module *TheModule;  // all the generated code
+  symbol_table symtbl;
+  vector<LoopAST *> enclosingLoops;  // loops around the statement being resolved, innermost last
+  method_effects *effects;           // of the method being resolved, NULL outside methods
+  ProgramAST *parsedProgram;         // set by the program rule
+
+  decaf_compiler(ostream &o = cout)
+    : printAST(false), indentAST(false), handScanner(false), optimizeIR(false), out(o),
+      Builder(TheContext), TheModule(NULL), effects(NULL), parsedProgram(NULL) {}
+  ~decaf_compiler();
+
+  // Compile the file at path (stdin if NULL) into module(). Returns -1
+  // if the file cannot be read, 0 on success, DECAF_SYNTAX_ERROR or
+  // DECAF_SEMANTIC_ERROR. A decaf_compiler compiles one file.
+  int compile(const char *path);
+  llvm::Module *module() { return TheModule; }
+  symbol_id intern(const string &name);
+};
 
 #endif
 
@@ -0,0 +1,411 @@
+
+// decafcomp-test - runs every testcase through the compiler linked into
+// this process, instead of a decafcomp and an llvm-run pipeline per
+// testcase. Each program is compiled by a decaf_compiler, run with
+// MCJIT, and its output and exit status are compared with references/
+// the way check.py compares the output of zipout.py:
+//
+//   NAME.out  the compiler's stdout followed by the program's stdout
+//   NAME.ret  1 if compiling or running failed, else 0
+//
+// A testcase with no reference file is checked against the program in
+// dev_llvm/NAME.llvm run the same way, when there is one.
+//
+// The program runs in a forked child so that a crash or an endless loop
+// only fails its own testcase; compiling stays in this process.
+//
+//   decafcomp-test [-s] [-O] [-v] [-t testcases] [-r references] [-l dev_llvm]
+//     -s  scan with the hand-written scanner
+//     -O  optimize each module, as decafcomp -O does
+//     -v  print the output of each failing testcase
+//
+//   decafcomp-test -j threads [-n rounds] [-s] [-O] [-v] [-t testcases]
+//     compile, but do not run, every testcase rounds times over (10 by
+//     default) on a pool of threads, and check that each compile gives
+//     the same result, output and module as compiling it alone. The
+//     parser, the scanner and the compiler keep no global state, so
+//     any difference is a bug.
+
+#include "decafcomp-defs.h"
+#include "llvm/ExecutionEngine/ExecutionEngine.h"
+#include "llvm/ExecutionEngine/MCJIT.h"
+#include "llvm/ExecutionEngine/SectionMemoryManager.h"
+#include "llvm/AsmParser/Parser.h"
+#include "llvm/IRReader/IRReader.h"
+#include "llvm/Support/DynamicLibrary.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <dirent.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+using namespace std;
+
+const int run_timeout = 10;   // seconds a testcase program may run
+
+static bool verbose = false;
+static bool hand_scanner = false;   // -s
+static bool optimize = false;       // -O
+
+static bool file_exists(const string &path) {
+  struct stat st;
+  return stat(path.c_str(), &st) == 0;
+}
+
+static string read_file(const string &path) {
+  ifstream in(path.c_str(), ios::binary);
+  stringstream s;
+  s << in.rdbuf();
+  return s.str();
+}
+
+// names in dir, sorted, that end in suffix (with the suffix removed)
+// or, if suffix is empty, that are directories
+static vector<string> list_dir(const string &dir, const string &suffix) {
+  vector<string> names;
+  DIR *d = opendir(dir.c_str());
+  if (d == NULL) {
+    return names;
+  }
+  while (struct dirent *e = readdir(d)) {
+    string name = e->d_name;
+    if (name[0] == '.') {
+      continue;
+    }
+    if (suffix.empty()) {
+      if (e->d_type == DT_DIR) {
+        names.push_back(name);
+      }
+    } else if (name.size() > suffix.size() && name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0) {
+      names.push_back(name.substr(0, name.size() - suffix.size()));
+    }
+  }
+  closedir(d);
+  sort(names.begin(), names.end());
+  return names;
+}
+
+// capture - sends stdout (and, unless verbose, stderr) to a temporary
+// file until the output is taken
+class capture {
+  int saved_out, saved_err, fd;
+public:
+  capture() {
+    cout.flush();
+    fflush(stdout);
+    fflush(stderr);
+    FILE *tmp = tmpfile();
+    fd = dup(fileno(tmp));
+    fclose(tmp);
+    saved_out = dup(STDOUT_FILENO);
+    saved_err = dup(STDERR_FILENO);
+    dup2(fd, STDOUT_FILENO);
+    if (!verbose) {
+      int null = open("/dev/null", O_WRONLY);
+      dup2(null, STDERR_FILENO);
+      close(null);
+    }
+  }
+  string take() {
+    cout.flush();
+    cerr.flush();
+    fflush(stdout);
+    fflush(stderr);
+    dup2(saved_out, STDOUT_FILENO);
+    dup2(saved_err, STDERR_FILENO);
+    close(saved_out);
+    close(saved_err);
+    string out;
+    char buf[1 << 16];
+    ssize_t n;
+    lseek(fd, 0, SEEK_SET);
+    while ((n = read(fd, buf, sizeof(buf))) > 0) {
+      out.append(buf, n);
+    }
+    close(fd);
+    return out;
+  }
+};
+
+// JIT and run main() of m in a child process, with stdin from input
+// (or /dev/null) and stdout going wherever it goes now. The child's
+// copy of m is handed to the JIT. Returns the exit status of the
+// program, or -1 if it could not be run or was killed.
+static int run_module(llvm::Module *m, const string &input) {
+  cout.flush();
+  fflush(stdout);
+  pid_t pid = fork();
+  if (pid < 0) {
+    return -1;
+  }
+  if (pid == 0) {
+    int in = open(input.empty() ? "/dev/null" : input.c_str(), O_RDONLY);
+    dup2(in, STDIN_FILENO);
+    close(in);
+    alarm(run_timeout);
+    string err;
+    llvm::ExecutionEngine *ee = llvm::EngineBuilder(std::unique_ptr<llvm::Module>(m))
+      .setErrorStr(&err)
+      .setEngineKind(llvm::EngineKind::JIT)
+      .setOptLevel(llvm::CodeGenOpt::None)
+      .setMCJITMemoryManager(std::unique_ptr<llvm::SectionMemoryManager>(new llvm::SectionMemoryManager()))
+      .create();
+    if (ee == NULL) {
+      cerr << "cannot run: " << err << endl;
+      _exit(1);
+    }
+    ee->finalizeObject();
+    int (*entry)() = (int (*)())ee->getFunctionAddress("main");
+    if (entry == NULL) {
+      cerr << "cannot run: no main" << endl;
+      _exit(1);
+    }
+    int status = entry();
+    fflush(stdout);
+    _exit(status);
+  }
+  int status;
+  while (waitpid(pid, &status, 0) < 0 && errno == EINTR) {
+  }
+  return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+typedef struct test_result {
+  string out;
+  int ret;
+} test_result;
+
+// compile and run a testcase like llvm-run does; *compile_ms gets the
+// time compiling took
+static test_result run_testcase(const string &source, const string &input, double *compile_ms) {
+  test_result r;
+  capture c;
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+  decaf_compiler compiler;
+  compiler.handScanner = hand_scanner;
+  compiler.optimizeIR = optimize;
+  int status = compiler.compile(source.c_str());
+  *compile_ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+  r.ret = 1;
+  if (status == 0) {
+    // run what llvm-as would make of the printed module: the text may
+    // read back as a valid module when the module itself is not
+    string text;
+    llvm::raw_string_ostream os(text);
+    compiler.module()->print(os, nullptr);
+    os.flush();
+    llvm::LLVMContext context;
+    llvm::SMDiagnostic diag;
+    std::unique_ptr<llvm::Module> m = llvm::parseAssemblyString(text, diag, context);
+    if (m && !llvm::verifyModule(*m, &llvm::errs())) {
+      r.ret = run_module(m.get(), input) == 0 ? 0 : 1;
+    }
+  }
+  r.out = c.take();
+  return r;
+}
+
+static test_result run_reference(const string &llvm_file, const string &input) {
+  test_result r;
+  capture c;
+  llvm::LLVMContext context;
+  llvm::SMDiagnostic diag;
+  std::unique_ptr<llvm::Module> m = llvm::parseIRFile(llvm_file, diag, context);
+  r.ret = 1;
+  if (m) {
+    r.ret = run_module(m.get(), input) == 0 ? 0 : 1;
+  }
+  r.out = c.take();
+  return r;
+}
+
+// what compiling a testcase gives, for -j
+typedef struct compile_result {
+  int status;
+  string out;
+  string module;
+} compile_result;
+
+static compile_result compile_only(const string &source) {
+  compile_result r;
+  ostringstream out;
+  decaf_compiler compiler(out);
+  compiler.handScanner = hand_scanner;
+  compiler.optimizeIR = optimize;
+  r.status = compiler.compile(source.c_str());
+  if (compiler.module() != NULL) {
+    llvm::raw_string_ostream os(r.module);
+    compiler.module()->print(os, nullptr);
+    os.flush();
+  }
+  r.out = out.str();
+  return r;
+}
+
+// the work shared by the -j threads: job j compiles testcase j modulo
+// the number of testcases, so the same testcases run side by side
+typedef struct stress_pool {
+  vector<string> sources;
+  vector<compile_result> expect;  // each testcase compiled alone
+  size_t jobs;
+  atomic<size_t> next;
+  mutex lock;                     // for differ
+  vector<string> differ;
+} stress_pool;
+
+static void stress_run(stress_pool *pool) {
+  for (size_t j = pool->next++; j < pool->jobs; j = pool->next++) {
+    size_t i = j % pool->sources.size();
+    compile_result r = compile_only(pool->sources[i]);
+    const compile_result &e = pool->expect[i];
+    if (r.status != e.status || r.out != e.out || r.module != e.module) {
+      lock_guard<mutex> hold(pool->lock);
+      pool->differ.push_back(pool->sources[i]);
+    }
+  }
+}
+
+static int stress(const vector<string> &sources, int nthreads, int rounds) {
+  stress_pool pool;
+  pool.sources = sources;
+  pool.jobs = sources.size() * rounds;
+  pool.next = 0;
+  // syntax errors go to stderr, from every thread at once
+  int saved_err = dup(STDERR_FILENO);
+  if (!verbose) {
+    int null = open("/dev/null", O_WRONLY);
+    dup2(null, STDERR_FILENO);
+    close(null);
+  }
+  for (size_t i = 0; i < sources.size(); i++) {
+    pool.expect.push_back(compile_only(sources[i]));
+  }
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+  vector<thread> workers;
+  for (int t = 0; t < nthreads; t++) {
+    workers.push_back(thread(stress_run, &pool));
+  }
+  for (size_t t = 0; t < workers.size(); t++) {
+    workers[t].join();
+  }
+  double wall_ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+  dup2(saved_err, STDERR_FILENO);
+  close(saved_err);
+  for (size_t i = 0; i < pool.differ.size(); i++) {
+    printf("DIFF %s\n", pool.differ[i].c_str());
+  }
+  printf("%zu compiles of %zu testcases on %d threads, %zu differ from compiling alone; %.1f ms\n",
+         pool.jobs, sources.size(), nthreads, pool.differ.size(), wall_ms);
+  return pool.differ.empty() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static vector<string> lines(const string &s) {
+  vector<string> v;
+  istringstream in(s);
+  for (string line; getline(in, line);) {
+    v.push_back(line);
+  }
+  return v;
+}
+
+int main(int argc, char **argv) {
+  string testcase_dir = "../testcases", ref_dir = "../references", llvm_dir = "../dev_llvm";
+  int nthreads = 0, rounds = 10;
+  int opt;
+  while ((opt = getopt(argc, argv, "sOvt:r:l:j:n:")) != -1) {
+    switch (opt) {
+    case 's': hand_scanner = true; break;
+    case 'O': optimize = true; break;
+    case 'v': verbose = true; break;
+    case 't': testcase_dir = optarg; break;
+    case 'r': ref_dir = optarg; break;
+    case 'l': llvm_dir = optarg; break;
+    case 'j': nthreads = atoi(optarg); break;
+    case 'n': rounds = atoi(optarg); break;
+    default:
+      cerr << "usage: decafcomp-test [-s] [-O] [-v] [-t testcases] [-r references] [-l dev_llvm]" << endl;
+      cerr << "       decafcomp-test -j threads [-n rounds] [-s] [-O] [-v] [-t testcases]" << endl;
+      return EXIT_FAILURE;
+    }
+  }
+  if (nthreads > 0) {
+    vector<string> sources;
+    vector<string> groups = list_dir(testcase_dir, "");
+    for (size_t g = 0; g < groups.size(); g++) {
+      vector<string> names = list_dir(testcase_dir + "/" + groups[g], ".decaf");
+      for (size_t i = 0; i < names.size(); i++) {
+        sources.push_back(testcase_dir + "/" + groups[g] + "/" + names[i] + ".decaf");
+      }
+    }
+    return stress(sources, nthreads, rounds);
+  }
+  llvm::InitializeNativeTarget();
+  llvm::InitializeNativeTargetAsmPrinter();
+  llvm::sys::DynamicLibrary::LoadLibraryPermanently(NULL);
+  signal(SIGPIPE, SIG_IGN);
+
+  int passed = 0, failed = 0, unchecked = 0;
+  double total_ms = 0;
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+  vector<string> groups = list_dir(testcase_dir, "");
+  for (size_t g = 0; g < groups.size(); g++) {
+    string dir = testcase_dir + "/" + groups[g];
+    vector<string> names = list_dir(dir, ".decaf");
+    for (size_t i = 0; i < names.size(); i++) {
+      string name = groups[g] + "/" + names[i];
+      string input = dir + "/" + names[i] + ".in";
+      if (!file_exists(input)) {
+        input.clear();
+      }
+      double ms;
+      test_result r = run_testcase(dir + "/" + names[i] + ".decaf", input, &ms);
+      total_ms += ms;
+
+      string ref = ref_dir + "/" + name;
+      string llvm_file = llvm_dir + "/" + names[i] + ".llvm";
+      bool checked = false, ok = true;
+      if (file_exists(ref + ".out")) {
+        checked = true;
+        ok = lines(r.out) == lines(read_file(ref + ".out"));
+      }
+      if (file_exists(ref + ".ret")) {
+        checked = true;
+        ok = ok && atoi(read_file(ref + ".ret").c_str()) == r.ret;
+      }
+      if (!checked && file_exists(llvm_file)) {
+        test_result expect = run_reference(llvm_file, input);
+        checked = true;
+        ok = r.ret == expect.ret && lines(r.out) == lines(expect.out);
+      }
+
+      const char *verdict = !checked ? "----" : ok ? "pass" : "FAIL";
+      printf("%s %-40s %8.3f ms\n", verdict, name.c_str(), ms);
+      if (checked && !ok && verbose) {
+        printf("exit status %d, output:\n%s", r.ret, r.out.c_str());
+      }
+      if (!checked) {
+        unchecked++;
+      } else if (ok) {
+        passed++;
+      } else {
+        failed++;
+      }
+    }
+  }
+  double wall_ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+  printf("passed %d, failed %d, no reference %d; compiling took %.1f ms, everything %.1f ms\n",
+         passed, failed, unchecked, total_ms, wall_ms);
+  return failed > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
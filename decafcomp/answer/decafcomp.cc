@@ -1,10 +1,12 @@
 
 #include "decafcomp-defs.h"
+#include "decaf-print.h"
+#include "llvm/ADT/SmallVector.h"
 #include <algorithm>
-#include <list>
 #include <ostream>
 #include <iostream>
 #include <sstream>
+#include <unordered_map>
 
 #ifndef YYTOKENTYPE
 #include "decafcomp.tab.h"
@@ -12,7 +14,36 @@
 
 using namespace std;
 
-symbol_table_list symtbl;
+decaf_memory memoryStats;
+
+#ifdef DECAF_MEMORY_ACCOUNTING
+// every allocation is counted by memoryStats, see decaf-memory.h
+void *operator new(size_t size) {
+  void *p = memoryStats.allocate(size);
+  if (p == NULL) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+void *operator new[](size_t size) { return operator new(size); }
+void operator delete(void *p) noexcept { memoryStats.release(p); }
+void operator delete[](void *p) noexcept { memoryStats.release(p); }
+void operator delete(void *p, size_t) noexcept { memoryStats.release(p); }
+void operator delete[](void *p, size_t) noexcept { memoryStats.release(p); }
+#endif
+
+symbol_id decaf_compiler::intern(const string &name)
+{
+  decaf_mem_category symbols(MEM_SYMBOLS);
+  unordered_map<string, symbol_id>::iterator i = symbol_ids.find(name);
+  if (i != symbol_ids.end()) {
+    return i->second;
+  }
+  symbol_id id = symbol_names.size();
+  symbol_ids[name] = id;
+  symbol_names.push_back(name);
+  return id;
+}
 
 static llvm::AllocaInst *CreateEntryBlockAlloca(llvm::Function *TheFunction,
                                           const std::string &VarName, llvm::Type *type) {
@@ -21,30 +52,35 @@ static llvm::AllocaInst *CreateEntryBlockAlloca(llvm::Function *TheFunction,
   return TmpB.CreateAlloca(type, nullptr, VarName);
 }
 
-llvm::Constant *getZeroInit(string type)
+// ASDL names used by print(), indexed by decafOp and decafType
+static const char *opName[] = {
+  "Plus", "Minus", "Mult", "Div", "Leftshift", "Rightshift", "Mod",
+  "Lt", "Gt", "Leq", "Geq", "Eq", "Neq", "And", "Or",
+  "UnaryMinus", "Not"
+};
+
+static const char *typeName[] = {
+  "IntType", "BoolType", "VoidType", "StringType"
+};
+
+llvm::Constant *getZeroInit(decaf_compiler &c, decafType type)
 {
-  llvm::Constant *Init;
-  if(type == "IntType")         
-  { Init = Builder.getInt32(0); } // 32 bit int
-  else if(type == "BoolType")  
-  { Init = Builder.getInt1(0); } // 1 bit int  
-  else 
-  { Init = NULL; } // void 
-  return Init;
+  switch(type) {
+  case TYPE_INT:  return c.Builder.getInt32(0); // 32 bit int
+  case TYPE_BOOL: return c.Builder.getInt1(0);  // 1 bit int
+  default:        return NULL;                // void
+  }
 }
 
-llvm::Type* getLLVMType(string type)
+llvm::Type* getLLVMType(decaf_compiler &c, decafType type)
 {
-  llvm::Type* LType;
-  if(type == "IntType")         
-  { LType = Builder.getInt32Ty();  } // 32 bit int
-  else if(type == "BoolType")  
-  { LType = Builder.getInt1Ty();   } // 1 bit int  
-  else if(type == "VoidType")  
-  { LType = Builder.getVoidTy();   } // void 
-  else if(type == "StringType") 
-  { LType = Builder.getInt8PtrTy();} // ptr to array of bytes
-  return LType;
+  switch(type) {
+  case TYPE_INT:    return c.Builder.getInt32Ty();   // 32 bit int
+  case TYPE_BOOL:   return c.Builder.getInt1Ty();    // 1 bit int
+  case TYPE_VOID:   return c.Builder.getVoidTy();    // void
+  case TYPE_STRING: return c.Builder.getInt8PtrTy(); // ptr to array of bytes
+  }
+  return NULL;
 }
 
 string ctoi(string str)
@@ -81,110 +117,266 @@ string ctoi(string str)
   return string(s.str());
 }
 
-descriptor* access_symtbl(string id)
+// look up a name during resolution; names that are not in scope are
+// semantic errors
+static descriptor *resolve_symbol(decaf_compiler &c, const string &name)
 {
-  for(symbol_table_list::iterator i = symtbl.begin(); i != symtbl.end(); ++i)
-  {
-    symbol_table::iterator find_id;
-    if((find_id = i->find(id)) != i->end())
-    {
-      return find_id->second; // second refers to descriptor* in map<string, descriptor*> 
-    }
-  } 
-  return NULL;
+  descriptor *d = c.symtbl.lookup(c.intern(name));
+  if (d == NULL) {
+    throw runtime_error(name + " is not declared");
+  }
+  return d;
+}
+
+static void init_descriptor(descriptor *d, int lineno, descriptor_kind kind, decafType type)
+{
+  d->lineno = lineno;
+  d->kind = kind;
+  d->type = type;
+  d->alloca_ptr = NULL;
 }
 
+class decaf_printer;
+
 /// decafAST - Base class for all abstract syntax tree nodes.
 class decafAST {
+  int Line, Column;  // where the statement or call starts, 0 if not set
 public:
+  decafAST() : Line(0), Column(0) {}
   virtual ~decafAST() {}
-  virtual string str() { return string(""); }
-  virtual llvm::Value *Codegen() = 0;
+  void setLocation(int line, int column) { Line = line; Column = column; }
+  int getLine() { return Line; }
+  int getColumn() { return Column; }
+  // print - queue the node as an ASDL term on out, see decaf_printer
+  virtual void print(decaf_printer &out) = 0;
+  // Resolve - bind every use of a name to its declaration's descriptor.
+  // Runs once over the whole program before Codegen, which then never
+  // looks up a name.
+  virtual void Resolve(decaf_compiler &c) {}
+  virtual llvm::Value *Codegen(decaf_compiler &c) = 0;
 };
 
-string getString(decafAST *d) {
-	if (d != NULL) {
-		return d->str();
-	} else {
-		return string("None");
+/// decaf_printer - writes an AST as an ASDL term without recursing, as
+/// generated programs nest expressions and blocks far deeper than the
+/// native stack allows. A node's print() only queues its pieces in
+/// order, the text around its children and the children themselves;
+/// the printer then writes them from an explicit stack. The text has
+/// to outlive the print, so it is either a literal or a member of the
+/// node.
+class decaf_printer {
+	struct piece {
+		decafAST *node;   // NULL for text
+		const char *text;
+		size_t len;
+	};
+	ostream &out;
+	std::vector<piece> work;
+	void push(decafAST *node, const char *text, size_t len) {
+		piece p = { node, text, len };
+		work.push_back(p);
 	}
-}
-
-template <class T>
-string commaList(list<T> vec) {
-    string s("");
-    for (typename list<T>::iterator i = vec.begin(); i != vec.end(); i++) { 
-        s = s + (s.empty() ? string("") : string(",")) + (*i)->str(); 
-    }   
-    if (s.empty()) {
-        s = string("None");
-    }   
-    return s;
-}
+public:
+	decaf_printer(ostream &o) : out(o) {}
+	decaf_printer &operator<<(const char *s) { push(NULL, s, strlen(s)); return *this; }
+	decaf_printer &operator<<(const string &s) { push(NULL, s.data(), s.size()); return *this; }
+	// a child, or None
+	void node(decafAST *d) {
+		if (d != NULL) {
+			push(d, NULL, 0);
+		} else {
+			*this << "None";
+		}
+	}
+	// the children of a list separated by commas, or None
+	template <class T>
+	void list(const llvm::SmallVectorImpl<T> &vec) {
+		if (vec.empty()) {
+			*this << "None";
+			return;
+		}
+		for (typename llvm::SmallVectorImpl<T>::const_iterator i = vec.begin(); i != vec.end(); i++) {
+			if (i != vec.begin()) {
+				*this << ",";
+			}
+			push(*i, NULL, 0);
+		}
+	}
+	void print(decafAST *root) {
+		node(root);
+		while (!work.empty()) {
+			piece p = work.back();
+			work.pop_back();
+			if (p.node == NULL) {
+				out.write(p.text, p.len);
+				continue;
+			}
+			// the node queues its pieces first to last, the stack pops last first
+			size_t first = work.size();
+			p.node->print(*this);
+			std::reverse(work.begin() + first, work.end());
+		}
+	}
+};
 
 template <class T>
-llvm::Value *listCodegen(list<T> vec) {
+llvm::Value *listCodegen(decaf_compiler &c, const llvm::SmallVectorImpl<T> &vec) {
 	llvm::Value *val = NULL;
-	for (typename list<T>::iterator i = vec.begin(); i != vec.end(); i++) { 
-		llvm::Value *j = (*i)->Codegen();
+	for (typename llvm::SmallVectorImpl<T>::const_iterator i = vec.begin(); i != vec.end(); i++) { 
+		llvm::Value *j = (*i)->Codegen(c);
 		if (j != NULL) { val = j; }
 	}	
 	return val;
 }
 
+/// decafASTList - children of a list node, stored contiguously.
+/// Most lists are short (parameters, arguments, the statements of a
+/// block), so the first few children live inside the node itself.
+typedef llvm::SmallVector<decafAST *, 4> decafASTList;
+
 /// decafStmtList - List of Decaf statements
 class decafStmtList : public decafAST {
-	list<decafAST *> stmts;
+	decafASTList stmts;
 public:
 	decafStmtList() {}
 	~decafStmtList() {
-		for (list<decafAST *>::iterator i = stmts.begin(); i != stmts.end(); i++) { 
+		for (decafASTList::iterator i = stmts.begin(); i != stmts.end(); i++) { 
 			delete *i;
 		}
 	}
-	list<decafAST*> return_list() {
+	const decafASTList &return_list() {
 		return stmts;
 	}
 	int size() { return stmts.size(); }
-	void push_front(decafAST *e) { stmts.push_front(e); }
 	void push_back(decafAST *e) { stmts.push_back(e); }
-	string str() { return commaList<class decafAST *>(stmts); }
-	llvm::Value *Codegen() { 
-		return listCodegen<decafAST *>(stmts); 
+	void print(decaf_printer &out) { out.list(stmts); }
+	void Resolve(decaf_compiler &c) {
+		for (decafASTList::iterator i = stmts.begin(); i != stmts.end(); i++) { 
+			(*i)->Resolve(c);
+		}
+	}
+	llvm::Value *Codegen(decaf_compiler &c) { 
+		return listCodegen<decafAST *>(c, stmts); 
 	}
 };
 
+/// decafCompoundAST - a statement with statements nested in it: blocks,
+/// if, while and for. These nest as deeply as the parser lets them, so
+/// Resolve and Codegen do not recurse into the nested statements but run
+/// the compound statements in steps from an explicit stack. A step does
+/// the node's work up to its next nested statement and returns it, or
+/// returns NULL when the node is done.
+class decafCompoundAST : public decafAST {
+	typedef decafAST *(decafCompoundAST::*step_fn)(decaf_compiler &c, int step);
+	struct frame {
+		decafCompoundAST *node;
+		int step;
+	};
+	// run this node and the compound statements in it step by step,
+	// handing the other statements to Resolve (codegen false) or Codegen
+	void run(decaf_compiler &c, step_fn next_step, bool codegen) {
+		frame root = { this, 0 };
+		std::vector<frame> open(1, root);
+		while (!open.empty()) {
+			frame &f = open.back();
+			if (codegen) { c.debug.at(c.Builder, f.node->getLine(), f.node->getColumn()); }
+			decafAST *next = (f.node->*next_step)(c, f.step++);
+			if (next == NULL) {
+				open.pop_back();
+				continue;
+			}
+			decafCompoundAST *compound = dynamic_cast<decafCompoundAST *>(next);
+			if (compound != NULL) {
+				frame nested = { compound, 0 };
+				open.push_back(nested);
+			} else if (codegen) {
+				c.debug.at(c.Builder, next->getLine(), next->getColumn());
+				next->Codegen(c);
+			} else {
+				next->Resolve(c);
+			}
+		}
+	}
+public:
+	virtual decafAST *resolveStep(decaf_compiler &c, int step) = 0;
+	virtual decafAST *codegenStep(decaf_compiler &c, int step) = 0;
+	void Resolve(decaf_compiler &c) { run(c, &decafCompoundAST::resolveStep, false); }
+	llvm::Value *Codegen(decaf_compiler &c) {
+		run(c, &decafCompoundAST::codegenStep, true);
+		return NULL;
+	}
+};
+
+// the i-th statement of a block, counting its variable declarations
+// first, or NULL past the last one
+static decafAST *blockItem(decafStmtList *vars, decafStmtList *stmts, int i)
+{
+	if (vars != NULL) {
+		if (i < vars->size()) {
+			return vars->return_list()[i];
+		}
+		i -= vars->size();
+	}
+	if (stmts != NULL && i < stmts->size()) {
+		return stmts->return_list()[i];
+	}
+	return NULL;
+}
+
+// true once the block being generated ends in a branch or return. The
+// statements after a return, break or continue cannot run, so the rest
+// of their block gets no code.
+static bool blockTerminated(decaf_compiler &c)
+{
+	return c.Builder.GetInsertBlock()->getTerminator() != NULL;
+}
+
+// add bb, created without a function, after the blocks generated so far
+// and generate code into it
+static void startBlock(decaf_compiler &c, llvm::BasicBlock *bb)
+{
+	c.Builder.GetInsertBlock()->getParent()->getBasicBlockList().push_back(bb);
+	c.Builder.SetInsertPoint(bb);
+}
+
 class ExternVarDefAST : public decafAST {
-	string Type;
+	decafType Type;
 public:
-	ExternVarDefAST(string type) : Type(type) {}
-	string str() {
-		return string("VarDef") + "(" + Type + ")";
+	ExternVarDefAST(decafType type) : Type(type) {}
+	void print(decaf_printer &out) {
+		out << "VarDef(" << typeName[Type] << ")";
 	}
-	string getVarType() {
+	decafType getVarType() {
 		return Type;
 	}
-	llvm::Value *Codegen(){
+	llvm::Value *Codegen(decaf_compiler &c){
 		return NULL;
 	}
 };
 
 class ExternFunctionAST : public decafAST {
 	string Name;
-	string ReturnType;
+	descriptor Desc;
+	decafType ReturnType;
 	decafStmtList *ParameterTypeList;
 public:
-	ExternFunctionAST(string name, string type, decafStmtList *types) : Name(name), ReturnType(type), ParameterTypeList(types) {}
-	string str() {
-		return string("ExternFunction") + "(" + Name + "," + ReturnType + "," + getString(ParameterTypeList) + ")";
+	ExternFunctionAST(string name, decafType type, decafStmtList *types, int lineno) : Name(name), ReturnType(type), ParameterTypeList(types) {
+		init_descriptor(&Desc, lineno, DESC_FUNC, type);
+	}
+	void print(decaf_printer &out) {
+		out << "ExternFunction(" << Name << "," << typeName[ReturnType] << ",";
+		out.node(ParameterTypeList);
+		out << ")";
+	}
+	void Resolve(decaf_compiler &c) {
+		c.symtbl.insert(c.intern(Name), &Desc);
 	}
-	llvm::Value *Codegen(){
-		llvm::Type *returnTy = getLLVMType(ReturnType);
+	llvm::Value *Codegen(decaf_compiler &c){
+		llvm::Type *returnTy = getLLVMType(c, ReturnType);
 		std::vector<llvm::Type*> args;
 		if(ParameterTypeList != NULL){
-			list<decafAST*> stmts = ParameterTypeList->return_list();
-			for (list<decafAST *>::iterator i = stmts.begin(); i != stmts.end(); i++) { 
-				llvm::Type *type = getLLVMType(((ExternVarDefAST*)(*i))->getVarType());
+			const decafASTList &stmts = ParameterTypeList->return_list();
+			for (decafASTList::const_iterator i = stmts.begin(); i != stmts.end(); i++) { 
+				llvm::Type *type = getLLVMType(c, ((ExternVarDefAST*)(*i))->getVarType());
 				args.push_back(type);
 			}
 		}
@@ -192,54 +384,53 @@ public:
 			llvm::FunctionType::get(returnTy, args, false),
 			llvm::Function::ExternalLinkage,
 			Name,
-			TheModule);
-										
-		descriptor* d = new descriptor;
-    	d->type = ReturnType;
-    	d->func_ptr = func;
-    	d->arg_types = args;
-    	(symtbl.front())[Name] = d;
+			c.TheModule);
+
+		// C passes bool zero extended
+		for (unsigned i = 0; i < args.size(); i++) {
+			if(args[i]->isIntegerTy(1)) { func->addParamAttr(i, llvm::Attribute::ZExt); }
+		}
+		if(returnTy->isIntegerTy(1)) { func->addRetAttr(llvm::Attribute::ZExt); }
+
+		Desc.func_ptr = func;
 		return func;
 	}
 };
 
-llvm::Constant* getLLVMDefaultValue(string type)
+llvm::Constant* getLLVMDefaultValue(decaf_compiler &c, decafType type)
 {
-	llvm::Constant *value;
-	if(type == "IntType")         
-	{ value = Builder.getInt32(0);  } // 32 bit int
-	if(type == "BoolType")  
-	{ value = Builder.getInt1(0);   } // 1 bit int
-	return value;
+	return getZeroInit(c, type);
 }
 
-llvm::Value* getLLVMDefaultReturn(string returnType)
+llvm::Value* getLLVMDefaultReturn(decaf_compiler &c, decafType returnType)
 {
-	if(returnType == "IntType"){
-		return Builder.CreateRet(Builder.getInt32(0));
+	switch(returnType) {
+	case TYPE_INT:  return c.Builder.CreateRet(c.Builder.getInt32(0));
+	case TYPE_BOOL: return c.Builder.CreateRet(c.Builder.getInt1(0));
+	case TYPE_VOID: return c.Builder.CreateRet(nullptr);
+	default:        return NULL;
 	}
-	else if(returnType == "BoolType"){
-		return Builder.CreateRet(Builder.getInt1(0));
-	}
-	else if((returnType == "VoidType") /*|| returnType == ""*/){
-		return Builder.CreateRet(nullptr);
-	}
-	return NULL;
 }
 
 class FieldDeclScalarAST : public decafAST {
 	string Name;
-	string Type;
+	descriptor Desc;
+	decafType Type;
 public:
-	FieldDeclScalarAST(string name, string type) : Name(name), Type(type) {}
-	string str() {
-		return string("FieldDecl") + "(" + Name + "," + Type + "," + "Scalar" + ")";
+	FieldDeclScalarAST(string name, decafType type, int lineno) : Name(name), Type(type) {
+		init_descriptor(&Desc, lineno, DESC_GLOBAL, type);
 	}
-	llvm::Value *Codegen(){
-		llvm::Type *returnTy = getLLVMType(Type);
-		llvm::Constant *defaultVal = getLLVMDefaultValue(Type);
+	void print(decaf_printer &out) {
+		out << "FieldDecl(" << Name << "," << typeName[Type] << ",Scalar)";
+	}
+	void Resolve(decaf_compiler &c) {
+		c.symtbl.insert(c.intern(Name), &Desc);
+	}
+	llvm::Value *Codegen(decaf_compiler &c){
+		llvm::Type *returnTy = getLLVMType(c, Type);
+		llvm::Constant *defaultVal = getLLVMDefaultValue(c, Type);
 		llvm::GlobalVariable *gloabalVar = new llvm::GlobalVariable(
-			*TheModule, 
+			*c.TheModule, 
 			returnTy,
 			false,  // variable is mutable
 			llvm::GlobalValue::InternalLinkage, 
@@ -247,37 +438,39 @@ public:
 			Name
 		);
 
-		descriptor* d = new descriptor;
-		d->global_ptr = gloabalVar;
-		d->alloca_ptr = NULL;
-		(symtbl.front())[Name] = d;
+		Desc.global_ptr = gloabalVar;
+		c.debug.global(gloabalVar, Desc.lineno);
 		return gloabalVar;
 	}
 };
 
 class FieldDeclArrayAST : public decafAST {
 	string Name;
-	string Type;
+	descriptor Desc;
+	decafType Type;
 	string Size;
 public:
-	FieldDeclArrayAST(string name, string type, string size) : Name(name), Type(type), Size(size) {}
-	string str() {
-		return string("FieldDecl") + "(" + Name + "," + Type + "," + Size + ")";
+	FieldDeclArrayAST(string name, decafType type, string size, int lineno) : Name(name), Type(type), Size(size) {
+		init_descriptor(&Desc, lineno, DESC_GLOBAL, type);
+	}
+	void print(decaf_printer &out) {
+		out << "FieldDecl(" << Name << "," << typeName[Type] << "," << Size << ")";
 	}
-	llvm::Value *Codegen(){
+	void Resolve(decaf_compiler &c) {
+		c.symtbl.insert(c.intern(Name), &Desc);
+	}
+	llvm::Value *Codegen(decaf_compiler &c){
 		int size = atoi(Size.c_str());
 		// array size = size
-		llvm::ArrayType *arrayi32 = llvm::ArrayType::get(getLLVMType(Type), size);
+		llvm::ArrayType *arrayi32 = llvm::ArrayType::get(getLLVMType(c, Type), size);
 		// zeroinitalizer: initialize array to all zeroes
 		llvm::Constant *zeroInit = llvm::Constant::getNullValue(arrayi32);
 		// declare a global variable
-		llvm::GlobalVariable *gloabalVar = new llvm::GlobalVariable(*TheModule, arrayi32, false, llvm::GlobalValue::ExternalLinkage, zeroInit, Name);
+		llvm::GlobalVariable *gloabalVar = new llvm::GlobalVariable(*c.TheModule, arrayi32, false, llvm::GlobalValue::ExternalLinkage, zeroInit, Name);
 		// 3rd parameter to GlobalVariable is false because it is not a constant variable
 
-		descriptor* d = new descriptor;
-		d->global_ptr = gloabalVar;
-		d->alloca_ptr = NULL;
-		(symtbl.front())[Name] = d;
+		Desc.global_ptr = gloabalVar;
+		c.debug.global(gloabalVar, Desc.lineno);
 		return gloabalVar;
 	}
 };
@@ -286,15 +479,15 @@ class ConstantNumberExprAST : public decafAST {
 	string Value;
 public:
 	ConstantNumberExprAST(string value) : Value(value) {}
-	string str() {
-		return string("NumberExpr") + "(" + Value + ")";
+	void print(decaf_printer &out) {
+		out << "NumberExpr(" << Value << ")";
 	}
 	int getVal(){
 		int num_val = atoi(Value.c_str());
 		return num_val;
 	}
 	string getID() { return Value; }
-	llvm::Value *Codegen(){
+	llvm::Value *Codegen(decaf_compiler &c){
 		llvm::Value *val;
 			int num;
 			num = atoi(Value.c_str());
@@ -305,7 +498,7 @@ public:
 					break;
 				}
 			}
-			val = Builder.getInt32(num);
+			val = c.Builder.getInt32(num);
 			return val;
 	}
 };
@@ -314,187 +507,286 @@ class ConstantBoolExprAST : public decafAST {
 	string Value;
 public:
 	ConstantBoolExprAST(string value) : Value(value) {}
-	string str() {
-		return string("BoolExpr") + "(" + Value + ")";
+	void print(decaf_printer &out) {
+		out << "BoolExpr(" << Value << ")";
 	}
 	int getVal(){
 		int num_val = atoi(Value.c_str());
 		return num_val;
 	}
 	string getID() { return Value; }
-	llvm::Value *Codegen(){
+	llvm::Value *Codegen(decaf_compiler &c){
 		llvm::Value *val;
-		if(Value == "True" ) { val = Builder.getInt1(1);}
-		if(Value == "False") { val = Builder.getInt1(0);}
+		if(Value == "True" ) { val = c.Builder.getInt1(1);}
+		if(Value == "False") { val = c.Builder.getInt1(0);}
 		return val;
 	}
 };
 
 class FieldDeclAssignAST : public decafAST {
 	string Name;
-	string Type;
+	descriptor Desc;
+	decafType Type;
 	decafAST *Constant;
 public:
-	FieldDeclAssignAST(string name, string type, decafAST *constant) : Name(name), Type(type), Constant(constant) {}
-	string str() {
-		return string("AssignGlobalVar") + "(" + Name + "," + Type + "," + getString(Constant) + ")";
+	FieldDeclAssignAST(string name, decafType type, decafAST *constant, int lineno) : Name(name), Type(type), Constant(constant) {
+		init_descriptor(&Desc, lineno, DESC_GLOBAL, type);
+	}
+	void print(decaf_printer &out) {
+		out << "AssignGlobalVar(" << Name << "," << typeName[Type] << ",";
+		out.node(Constant);
+		out << ")";
 	}
-	llvm::Value *Codegen(){
-		llvm::Type *returnTy = getLLVMType(Type);
-		llvm::Value *value = Constant->Codegen();
+	void Resolve(decaf_compiler &c) {
+		c.symtbl.insert(c.intern(Name), &Desc);
+	}
+	llvm::Value *Codegen(decaf_compiler &c){
+		llvm::Type *returnTy = getLLVMType(c, Type);
+		llvm::Value *value = Constant->Codegen(c);
 		llvm::GlobalVariable *gloabalVar = new llvm::GlobalVariable(
-			*TheModule, 
+			*c.TheModule, 
 			returnTy, 
 			false,  // variable is mutable
 			llvm::GlobalValue::InternalLinkage, 
 			(llvm::Constant *)value,
 			Name);
 
-		descriptor* d = new descriptor;
-		d->global_ptr = gloabalVar;
-		d->alloca_ptr = NULL;
-		(symtbl.front())[Name] = d;
+		Desc.global_ptr = gloabalVar;
+		c.debug.global(gloabalVar, Desc.lineno);
 		return gloabalVar;
 	}
 };
 
-class BlockAST : public decafAST {
+class BlockAST : public decafCompoundAST {
 	decafStmtList *VarDecList;
 	decafStmtList *StmtList;
 public:
 	BlockAST(decafStmtList *vdL, decafStmtList *stL) : VarDecList(vdL), StmtList(stL) {}
-	string str() {
-		return string("Block") + "(" + getString(VarDecList) + "," + getString(StmtList) + ")";
-	}
-	llvm::Value *Codegen(){
-		symbol_table syms;
-		symtbl.push_front(syms);
-		if(VarDecList != NULL) { VarDecList->Codegen(); }
-		if(StmtList != NULL) { StmtList->Codegen();    }
-		symtbl.pop_front();
-		return NULL;
-	}
+	void print(decaf_printer &out) {
+		out << "Block(";
+		out.node(VarDecList);
+		out << ",";
+		out.node(StmtList);
+		out << ")";
+	}
+	decafAST *resolveStep(decaf_compiler &c, int step) {
+		if(step == 0) { c.symtbl.enter_scope(); }
+		decafAST *next = blockItem(VarDecList, StmtList, step);
+		if(next == NULL) { c.symtbl.exit_scope(); }
+		return next;
+	}
+	decafAST *codegenStep(decaf_compiler &c, int step) {
+		if(step == 0) { c.debug.enterBlock(getLine(), getColumn()); }
+		decafAST *next = blockTerminated(c) ? NULL : blockItem(VarDecList, StmtList, step);
+		if(next == NULL) { c.debug.leaveBlock(); }
+		return next;
+	}
+	bool empty() { return blockItem(VarDecList, StmtList, 0) == NULL; }
 };
 
-class MethodBlockAST : public decafAST {
+class MethodBlockAST : public decafCompoundAST {
 	string Name;
-	string ReturnType;
+	decafType ReturnType;
+	bool IsMethodBody; // false for nested blocks, which get no default return
 	std::vector<string> arg_names;
 	decafStmtList *VarDecList;
 	decafStmtList *StmtList;
 public:
-	MethodBlockAST(decafStmtList *vdL, decafStmtList *stL) : VarDecList(vdL), StmtList(stL) {}
-	string str() {
-			return string("MethodBlock") + "(" + getString(VarDecList) + "," + getString(StmtList) + ")";
+	MethodBlockAST(decafStmtList *vdL, decafStmtList *stL) : IsMethodBody(false), VarDecList(vdL), StmtList(stL) {}
+	void print(decaf_printer &out) {
+		out << "MethodBlock(";
+		out.node(VarDecList);
+		out << ",";
+		out.node(StmtList);
+		out << ")";
 	}
 	void setName(string name) {
 		Name = name;
 	}
-	void setReturn(string returnTy) {
+	void setReturn(decafType returnTy) {
 		ReturnType = returnTy;
+		IsMethodBody = true;
 	}
-	string getReturn() {
+	decafType getReturn() {
 		return ReturnType;
 	}
 	void setArgs(std::vector<string> args) {
 		arg_names = args;
 	}
-	llvm::Value *Codegen(){
-		symbol_table syms;
-		symtbl.push_front(syms);
-		if(VarDecList != NULL) { VarDecList->Codegen(); }
-		if(StmtList != NULL) { StmtList->Codegen();    }
-		getLLVMDefaultReturn(ReturnType);
-		symtbl.pop_front();
-		return NULL;
+	decafAST *resolveStep(decaf_compiler &c, int step) {
+		if(step == 0) { c.symtbl.enter_scope(); }
+		decafAST *next = blockItem(VarDecList, StmtList, step);
+		if(next == NULL) { c.symtbl.exit_scope(); }
+		return next;
+	}
+	// the method's own block is the subprogram's scope, nested ones get
+	// a lexical block
+	decafAST *codegenStep(decaf_compiler &c, int step) {
+		if(step == 0 && !IsMethodBody) { c.debug.enterBlock(getLine(), getColumn()); }
+		decafAST *next = blockTerminated(c) ? NULL : blockItem(VarDecList, StmtList, step);
+		if(next == NULL && IsMethodBody && !blockTerminated(c)) { getLLVMDefaultReturn(c, ReturnType); }
+		if(next == NULL && !IsMethodBody) { c.debug.leaveBlock(); }
+		return next;
 	}
 };
 
 class MethodVarDefAST : public decafAST {
 	string Name;
-	string Type;
+	descriptor Desc;
+	decafType Type;
 public:
-	MethodVarDefAST(string name, string type) : Name(name), Type(type) {}
-	string str() {
-		return string("VarDef") + "(" + Name + "," + Type + ")";
+	MethodVarDefAST(string name, decafType type, int lineno) : Name(name), Type(type) {
+		init_descriptor(&Desc, lineno, DESC_LOCAL, type);
+	}
+	void print(decaf_printer &out) {
+		out << "VarDef(" << Name << "," << typeName[Type] << ")";
 	}
-	string getVarType() {
+	decafType getVarType() {
 		return Type;
 	}
 	string getVarName() {
 		return Name;
 	}
-	llvm::Value *Codegen(){
+	descriptor *getDescriptor() {
+		return &Desc;
+	}
+	void Resolve(decaf_compiler &c) {
+		if(Name.empty()) { return; }
+		c.symtbl.insert(c.intern(Name), &Desc);
+	}
+	llvm::Value *Codegen(decaf_compiler &c){
 		if(Name.empty()) { return NULL; }
 
-		llvm::Type *type = getLLVMType(Type);
+		llvm::Type *type = getLLVMType(c, Type);
 		llvm::AllocaInst *Alloca = NULL;
 
-		Alloca = Builder.CreateAlloca(type, 0, Name);
+		Alloca = c.Builder.CreateAlloca(type, 0, Name);
+		c.debug.local(c.Builder, Alloca, Name, Desc.lineno);
 		
-		descriptor* d = new descriptor;
-		d->type = Type;
-		d->alloca_ptr = Alloca;
-		d->global_ptr = NULL;
-		(symtbl.front())[Name] = d;
+		Desc.alloca_ptr = Alloca;
 		return NULL;
 	}
 };
 
+/// method_effects - what the body of a method does, noted while it is
+/// resolved, and the function attributes inferAttributes finds from it
+struct method_effects {
+	bool readsGlobals;
+	bool writesGlobals;
+	bool hasLoops;
+	std::vector<descriptor *> callees;  // methods and externs it calls
+	bool readNone, readOnly, noRecurse, willReturn;
+	bool reachesExterns;                // it or a method it calls calls an extern
+	method_effects() : readsGlobals(false), writesGlobals(false), hasLoops(false),
+		readNone(false), readOnly(false), noRecurse(false), willReturn(false), reachesExterns(true) {}
+};
+
+// note that the method being resolved uses the variable d
+static void noteAccess(decaf_compiler &c, descriptor *d, bool write)
+{
+	if(c.effects == NULL || d->kind != DESC_GLOBAL) { return; }
+	if(write) {
+		c.effects->writesGlobals = true;
+	} else {
+		c.effects->readsGlobals = true;
+	}
+}
+
 class MethodDeclAST : public decafAST {
 	string Name;
-	string ReturnType;
+	descriptor Desc;
+	decafType ReturnType;
 	llvm::Function *func_ptr;
 	llvm::BasicBlock *basic_b;
 	decafStmtList *ParameterList;
 	MethodBlockAST *MethodBlock;
+	method_effects Effects;
 public:
-	MethodDeclAST(string name, string type, decafStmtList *params, MethodBlockAST *block) : Name(name), ReturnType(type), ParameterList(params), MethodBlock(block) {}
-	string str() {
-		return string("Method") + "(" + Name + "," + ReturnType + "," + getString(ParameterList) + "," + getString(MethodBlock) + ")";
-	}
+	MethodDeclAST(string name, decafType type, decafStmtList *params, MethodBlockAST *block, int lineno) : Name(name), ReturnType(type), ParameterList(params), MethodBlock(block) {
+		init_descriptor(&Desc, lineno, DESC_FUNC, type);
+	}
+	void print(decaf_printer &out) {
+		out << "Method(" << Name << "," << typeName[ReturnType] << ",";
+		out.node(ParameterList);
+		out << ",";
+		out.node(MethodBlock);
+		out << ")";
+	}
+	// methods are declared before any body is resolved so that calls can
+	// refer to methods defined further down
+	void declare(decaf_compiler &c) {
+		c.symtbl.insert(c.intern(Name), &Desc);
+	}
+	// the parameters get their own scope around the method block
+	void Resolve(decaf_compiler &c) {
+		c.symtbl.enter_scope();
+		c.effects = &Effects;
+		if(ParameterList != NULL) { ParameterList->Resolve(c); }
+		if(MethodBlock != NULL) { MethodBlock->Resolve(c); }
+		c.effects = NULL;
+		c.symtbl.exit_scope();
+	}
+	descriptor *getDescriptor() { return &Desc; }
+	method_effects &getEffects() { return Effects; }
 	void set_ptr(llvm::Function *ptr) {
 		func_ptr = ptr;
 	}
 	void set_BB(llvm::BasicBlock *bb) {
 		basic_b = bb;
 	}
-	void back() {
-		Builder.SetInsertPoint(basic_b);
-		if(MethodBlock != NULL) { MethodBlock->Codegen(); }
+	const string &getName() { return Name; }
+	void back(decaf_compiler &c) {
+		c.Builder.SetInsertPoint(basic_b);
+		c.debug.enter(c.Builder, func_ptr);
+		if(MethodBlock != NULL) { MethodBlock->Codegen(c); }
+		c.debug.leave(c.Builder);
+		c.profile.method(func_ptr);
 	}
-	llvm::Value *Codegen(){
+	llvm::Value *Codegen(decaf_compiler &c){
 		MethodBlock->setReturn(ReturnType);
 		llvm::Value *val;
-		llvm::Type *returnTy = getLLVMType(ReturnType);
+		llvm::Type *returnTy = getLLVMType(c, ReturnType);
 
 		// fill up the args vector with types
 		std::vector<llvm::Type*> args;
 		std::vector<string> arg_names;
-		list<decafAST*> stmts;
+		std::vector<MethodVarDefAST*> params;
 		if(ParameterList != NULL){
-			stmts = ParameterList->return_list();
-			for (list<decafAST *>::iterator i = stmts.begin(); i != stmts.end(); i++) { 
-				llvm::Type *type = getLLVMType(((MethodVarDefAST*)(*i))->getVarType());
+			const decafASTList &stmts = ParameterList->return_list();
+			for (decafASTList::const_iterator i = stmts.begin(); i != stmts.end(); i++) { 
+				llvm::Type *type = getLLVMType(c, ((MethodVarDefAST*)(*i))->getVarType());
 				string name = ((MethodVarDefAST*)(*i))->getVarName();
 				args.push_back(type);
 				arg_names.push_back(name);
+				params.push_back((MethodVarDefAST*)(*i));
 			}
 		}
 
 		llvm::FunctionType *FT = llvm::FunctionType::get(returnTy, args, false);
-		llvm::Function *TheFunction = llvm::Function::Create(FT, llvm::Function::ExternalLinkage, Name, TheModule);
+		llvm::Function *TheFunction = llvm::Function::Create(FT, llvm::Function::ExternalLinkage, Name, c.TheModule);
+
+		// Decaf has no exceptions. Only main is called from outside the
+		// package, the other methods can use the fast calling convention.
+		// With -p every method writes its profile counters.
+		TheFunction->addFnAttr(llvm::Attribute::NoUnwind);
+		if(c.profile.enabled) {
+			// neither readnone nor readonly
+		} else if(Effects.readNone) {
+			TheFunction->addFnAttr(llvm::Attribute::ReadNone);
+		} else if(Effects.readOnly) {
+			TheFunction->addFnAttr(llvm::Attribute::ReadOnly);
+		}
+		if(Effects.noRecurse) { TheFunction->addFnAttr(llvm::Attribute::NoRecurse); }
+		if(Effects.willReturn) { TheFunction->addFnAttr(llvm::Attribute::WillReturn); }
+		if(Name != "main") { TheFunction->setCallingConv(llvm::CallingConv::Fast); }
 
-		descriptor* d = new descriptor;
-		d->type       = ReturnType;
-		d->func_ptr   = TheFunction;
-		d->arg_types  = args;
-		d->arg_names = arg_names;
-		(symtbl.front())[Name] = d;
+		Desc.func_ptr = TheFunction;
+		c.debug.function(TheFunction, Desc.lineno);
 
-		llvm::BasicBlock *BB = llvm::BasicBlock::Create(TheContext, "entry", TheFunction);
+		llvm::BasicBlock *BB = llvm::BasicBlock::Create(c.TheContext, "entry", TheFunction);
 		set_BB(BB);
-		Builder.SetInsertPoint(BB);
+		c.Builder.SetInsertPoint(BB);
+		c.debug.enter(c.Builder, TheFunction);
 		
 		int idx = 0;
 		for (auto &Arg : TheFunction->args()) {
@@ -502,16 +794,14 @@ public:
 
 			const llvm::PointerType *ptrTy = Arg.getType()->getPointerTo();
 			if(ptrTy == Alloca->getType()){
-				val = Builder.CreateStore(&Arg, Alloca);
+				val = c.Builder.CreateStore(&Arg, Alloca);
 			}
 
-			descriptor* d = new descriptor;
-			d->alloca_ptr = Alloca;
-			d->global_ptr = NULL;
-			string st = arg_names[idx];
+			params[idx]->getDescriptor()->alloca_ptr = Alloca;
+			c.debug.parameter(c.Builder, Alloca, arg_names[idx], idx + 1, params[idx]->getDescriptor()->lineno);
 			idx++;
-			(symtbl.front())[st] = d; 
 		}
+		c.debug.leave(c.Builder);
 
 		set_ptr(TheFunction);
 		return TheFunction;
@@ -522,41 +812,153 @@ public:
 class MethodCallAST : public decafAST
 {
   string Name;
+  descriptor *Decl;
   decafStmtList *ArgList;
 public: 
-	MethodCallAST(string name, decafStmtList *alist) : Name(name), ArgList(alist) {}  
+	MethodCallAST(string name, decafStmtList *alist) : Name(name), Decl(NULL), ArgList(alist) {}  
 	~MethodCallAST() {
 		if(ArgList != NULL) { delete ArgList; }
 	}
-	string str() {
-		return string("MethodCall") + "(" + Name + "," + getString(ArgList) +")"; 
+	void print(decaf_printer &out) {
+		out << "MethodCall(" << Name << ",";
+		out.node(ArgList);
+		out << ")";
+	}
+	void Resolve(decaf_compiler &c) {
+		Decl = resolve_symbol(c, Name);
+		if(Decl->kind != DESC_FUNC) {
+			throw runtime_error(Name + " is not a method");
+		}
+		if(c.effects != NULL) { c.effects->callees.push_back(Decl); }
+		if(ArgList != NULL) { ArgList->Resolve(c); }
 	}
-	llvm::Value *Codegen() {
-        llvm::Function *call = (access_symtbl(Name))->func_ptr;			
+	llvm::Value *Codegen(decaf_compiler &c) {
+        llvm::Function *call = Decl->func_ptr;			
 		bool isVoid = call->getReturnType()->isVoidTy();
 
 		llvm::Value* val = NULL;
 		std::vector<llvm::Value*> args;
-		list<decafAST*> stmts;
 		if(ArgList != NULL){
-			stmts = ArgList->return_list();
-			for (list<decafAST *>::iterator i = stmts.begin(); i != stmts.end(); i++) { 
-				llvm::Value *value = (*i)->Codegen();
+			const decafASTList &stmts = ArgList->return_list();
+			for (decafASTList::const_iterator i = stmts.begin(); i != stmts.end(); i++) { 
+				llvm::Value *value = (*i)->Codegen(c);
 				args.push_back(value);
 			}
 			int idx = 0;
 			for(auto arg = call->arg_begin(); arg != call->arg_end(); ++arg, idx++)
 				if(arg->getType()->isIntegerTy(32) && args[idx]->getType()->isIntegerTy(1)) {
-					llvm::Value *value = Builder.CreateZExt(args[idx], Builder.getInt32Ty(), "zexttmp");
+					llvm::Value *value = c.Builder.CreateZExt(args[idx], c.Builder.getInt32Ty(), "zexttmp");
 					args[idx] = value;
 				}
 		}
 	
-		val = Builder.CreateCall(call, args, isVoid ? "" : "calltmp"); 
-		return val;
+		c.debug.at(c.Builder, getLine(), getColumn());
+		llvm::CallInst *callInst = c.Builder.CreateCall(call, args, isVoid ? "" : "calltmp");
+		callInst->setCallingConv(call->getCallingConv());
+		return callInst;
 	}
 };
 
+// inferAttributes - the function attributes of the package's methods,
+// from what their bodies do and what they call. The strongly connected
+// components of the call graph are found with Tarjan's algorithm, which
+// finishes the components a component calls before it, so each method's
+// callees outside its own component are already done. An extern may do
+// anything, including calling the methods back.
+static void inferAttributes(const decafASTList &methods)
+{
+	std::unordered_map<descriptor *, int> index;  // callee -> method, externs are missing
+	std::vector<method_effects *> effects;
+	for (decafASTList::const_iterator i = methods.begin(); i != methods.end(); i++) {
+		MethodDeclAST *m = (MethodDeclAST *)(*i);
+		index[m->getDescriptor()] = effects.size();
+		effects.push_back(&m->getEffects());
+	}
+	int n = effects.size();
+	std::vector<int> order(n, -1), low(n), component(n, -1), stack, members;
+	std::vector<bool> onStack(n, false);
+	struct frame {
+		int method;
+		size_t callee;  // next callee to visit
+	};
+	std::vector<frame> open;
+	int visited = 0, components = 0;
+	for (int root = 0; root < n; root++) {
+		if (order[root] >= 0) { continue; }
+		frame f = { root, 0 };
+		open.push_back(f);
+		order[root] = low[root] = visited++;
+		stack.push_back(root);
+		onStack[root] = true;
+		while (!open.empty()) {
+			int m = open.back().method;
+			const std::vector<descriptor *> &callees = effects[m]->callees;
+			if (open.back().callee < callees.size()) {
+				std::unordered_map<descriptor *, int>::iterator it = index.find(callees[open.back().callee++]);
+				if (it == index.end()) { continue; }
+				int callee = it->second;
+				if (order[callee] < 0) {
+					frame g = { callee, 0 };
+					open.push_back(g);
+					order[callee] = low[callee] = visited++;
+					stack.push_back(callee);
+					onStack[callee] = true;
+				} else if (onStack[callee]) {
+					low[m] = std::min(low[m], order[callee]);
+				}
+				continue;
+			}
+			open.pop_back();
+			if (!open.empty()) {
+				int caller = open.back().method;
+				low[caller] = std::min(low[caller], low[m]);
+			}
+			if (low[m] != order[m]) { continue; }
+
+			// m is the root of a component: its methods share the attributes
+			members.clear();
+			int k;
+			do {
+				k = stack.back();
+				stack.pop_back();
+				onStack[k] = false;
+				component[k] = components;
+				members.push_back(k);
+			} while (k != m);
+			bool recursive = members.size() > 1, readNone = true, readOnly = true, externs = false, loops = false, calleesReturn = true;
+			for (size_t i = 0; i < members.size(); i++) {
+				method_effects *e = effects[members[i]];
+				readNone = readNone && !e->readsGlobals && !e->writesGlobals;
+				readOnly = readOnly && !e->writesGlobals;
+				loops = loops || e->hasLoops;
+				for (size_t j = 0; j < e->callees.size(); j++) {
+					std::unordered_map<descriptor *, int>::iterator it = index.find(e->callees[j]);
+					if (it == index.end()) {
+						externs = true;
+					} else if (component[it->second] == components) {
+						recursive = true;
+					} else {
+						method_effects *callee = effects[it->second];
+						readNone = readNone && callee->readNone;
+						readOnly = readOnly && callee->readOnly;
+						externs = externs || callee->reachesExterns;
+						calleesReturn = calleesReturn && callee->willReturn;
+					}
+				}
+			}
+			for (size_t i = 0; i < members.size(); i++) {
+				method_effects *e = effects[members[i]];
+				e->reachesExterns = externs;
+				e->readNone = readNone && !externs;
+				e->readOnly = readOnly && !externs;
+				e->noRecurse = !recursive && !externs;
+				e->willReturn = e->noRecurse && !loops && calleesReturn;
+			}
+			components++;
+		}
+	}
+}
+
 class PackageAST : public decafAST {
 	string Name;
 	decafStmtList *FieldDeclList;
@@ -568,22 +970,45 @@ public:
 		if (FieldDeclList != NULL) { delete FieldDeclList; }
 		if (MethodDeclList != NULL) { delete MethodDeclList; }
 	}
-	string str() { 
-		return string("Package") + "(" + Name + "," + getString(FieldDeclList) + "," + getString(MethodDeclList) + ")";
+	void print(decaf_printer &out) {
+		out << "Package(" << Name << ",";
+		out.node(FieldDeclList);
+		out << ",";
+		out.node(MethodDeclList);
+		out << ")";
+	}
+	void Resolve(decaf_compiler &c) {
+		if (NULL != FieldDeclList) {
+			FieldDeclList->Resolve(c);
+		}
+		if (NULL != MethodDeclList) {
+			const decafASTList &stmts = MethodDeclList->return_list();
+			for (decafASTList::const_iterator i = stmts.begin(); i != stmts.end(); i++) {   
+				((MethodDeclAST*)(*i))->declare(c);
+			}
+			MethodDeclList->Resolve(c);
+			inferAttributes(stmts);
+		}
 	}
-	llvm::Value *Codegen() { 
+	llvm::Value *Codegen(decaf_compiler &c) { 
 		llvm::Value *val = NULL;
-		TheModule->setModuleIdentifier(llvm::StringRef(Name));
+		c.TheModule->setModuleIdentifier(llvm::StringRef(Name));
 		if (NULL != FieldDeclList) {
-			val = FieldDeclList->Codegen();
+			decaf_phase phase(c.timer, "fields");
+			val = FieldDeclList->Codegen(c);
 		}
 		if (NULL != MethodDeclList) {
-			val = MethodDeclList->Codegen();
+			{
+				decaf_phase phase(c.timer, "method prototypes");
+				val = MethodDeclList->Codegen(c);
+			}
 
-			list<decafAST*>stmts = MethodDeclList->return_list();
-			for (list<decafAST*>::iterator i = stmts.begin(); i != stmts.end(); i++) {   
+			decaf_phase phase(c.timer, "method bodies");
+			const decafASTList &stmts = MethodDeclList->return_list();
+			for (decafASTList::const_iterator i = stmts.begin(); i != stmts.end(); i++) {   
 				MethodDeclAST* e = (MethodDeclAST*)(*i);
-				e->back();
+				decaf_phase method(c.timer, "method", e->getName());
+				e->back(c);
 			}
 
 		}
@@ -602,14 +1027,29 @@ public:
 		if (ExternList != NULL) { delete ExternList; } 
 		if (PackageDef != NULL) { delete PackageDef; }
 	}
-	string str() { return string("Program") + "(" + getString(ExternList) + "," + getString(PackageDef) + ")"; }
-	llvm::Value *Codegen() { 
+	void print(decaf_printer &out) {
+		out << "Program(";
+		out.node(ExternList);
+		out << ",";
+		out.node(PackageDef);
+		out << ")";
+	}
+	void Resolve(decaf_compiler &c) {
+		if (NULL != ExternList) {
+			ExternList->Resolve(c);
+		}
+		if (NULL != PackageDef) {
+			PackageDef->Resolve(c);
+		}
+	}
+	llvm::Value *Codegen(decaf_compiler &c) { 
 		llvm::Value *val = NULL;
 		if (NULL != ExternList) {
-			val = ExternList->Codegen();
+			decaf_phase phase(c.timer, "externs");
+			val = ExternList->Codegen(c);
 		}
 		if (NULL != PackageDef) {
-			val = PackageDef->Codegen();
+			val = PackageDef->Codegen(c);
 		} else {
 			throw runtime_error("no package definition in decaf program");
 		}
@@ -620,29 +1060,35 @@ public:
 class ValueVariableExprAST : public decafAST
 {
 	string Name;
+	descriptor *Decl;
 	decafAST* IndexExpr;
 public: 
-	ValueVariableExprAST(string name) : Name(name) {}
-	string getID() { return Name; }
-	string str() {
-		return string("VariableExpr") + "(" + Name + ")";
-	}
-	llvm::Value *Codegen() {
-		descriptor* d  = access_symtbl(Name);
+	ValueVariableExprAST(string name) : Name(name), Decl(NULL) {}
+	const string &getID() { return Name; }
+	descriptor *getDecl() { return Decl; }
+	void print(decaf_printer &out) {
+		out << "VariableExpr(" << Name << ")";
+	}
+	void Resolve(decaf_compiler &c) {
+		Decl = resolve_symbol(c, Name);
+		noteAccess(c, Decl, false);
+	}
+	llvm::Value *Codegen(decaf_compiler &c) {
+		descriptor* d  = Decl;
 		if(d != NULL) {
-			if(d->alloca_ptr != NULL) {
+			if(d->kind == DESC_LOCAL) {
 				llvm::Value *val;
-				val = Builder.CreateLoad(d->alloca_ptr);
+				val = c.Builder.CreateLoad(d->alloca_ptr);
 				val->setName(Name);
 				return val;
-				//return Builder.CreateLoad(d->alloca_ptr);  
+				//return c.Builder.CreateLoad(d->alloca_ptr);  
 			}
-			else if(d->global_ptr != NULL) {
+			else if(d->kind == DESC_GLOBAL) {
 				llvm::Value *val;
-				val = Builder.CreateLoad(d->global_ptr);
+				val = c.Builder.CreateLoad(d->global_ptr);
 				val->setName(Name);
 				return val;
-				//return Builder.CreateLoad(d->global_ptr);  
+				//return c.Builder.CreateLoad(d->global_ptr);  
 			}
 		}
 		return NULL; 
@@ -652,47 +1098,56 @@ public:
 class ValueArrayLocExprAST : public decafAST
 {
 	string Name;
+	descriptor *Decl;
 	decafAST* IndexExpr;
 public: 
-	ValueArrayLocExprAST(string name, decafAST* index) : Name(name), IndexExpr(index) {}
+	ValueArrayLocExprAST(string name, decafAST* index) : Name(name), Decl(NULL), IndexExpr(index) {}
 	
-	string getID() { return Name; }  
+	const string &getID() { return Name; }  
+	descriptor *getDecl() { return Decl; }
 	decafAST* getIndexExpr() { return IndexExpr; }
 
-	llvm::Value *getIndexVal() {
+	llvm::Value *getIndexVal(decaf_compiler &c) {
 		ConstantBoolExprAST* derived = dynamic_cast<ConstantBoolExprAST*>(IndexExpr);
 		if(derived) { throw runtime_error("Bool Index"); }
-		llvm::Value *indexVal = IndexExpr->Codegen();
+		llvm::Value *indexVal = IndexExpr->Codegen(c);
 		return indexVal;
 	}
 	   
-	string str() {
-		return string("ArrayLocExpr") + "(" + Name + "," + getString(IndexExpr) +")";
-	}
-	llvm::Value *Codegen() {
-		descriptor* d  = access_symtbl(Name);
+	void print(decaf_printer &out) {
+		out << "ArrayLocExpr(" << Name << ",";
+		out.node(IndexExpr);
+		out << ")";
+	}
+	void Resolve(decaf_compiler &c) {
+		Decl = resolve_symbol(c, Name);
+		noteAccess(c, Decl, false);
+		IndexExpr->Resolve(c);
+	}
+	llvm::Value *Codegen(decaf_compiler &c) {
+		descriptor* d  = Decl;
 		if(d != NULL) {
-			if(d->alloca_ptr != NULL) {
+			if(d->kind == DESC_LOCAL) {
 				llvm::Value *val;
-				val = Builder.CreateLoad(d->alloca_ptr);
+				val = c.Builder.CreateLoad(d->alloca_ptr);
 				val->setName(Name);
 				return val;
-				//return Builder.CreateLoad(d->alloca_ptr);  
+				//return c.Builder.CreateLoad(d->alloca_ptr);  
 			}
-			else if(d->global_ptr != NULL) {
-				llvm::Value *ArrayLoc = Builder.CreateStructGEP(d->global_ptr, 0, "arrayloc");
+			else if(d->kind == DESC_GLOBAL) {
+				llvm::Value *ArrayLoc = c.Builder.CreateStructGEP(d->global_ptr, 0, "arrayloc");
 
 				ConstantBoolExprAST* derived = dynamic_cast<ConstantBoolExprAST*>(IndexExpr);
 				if(derived) { throw runtime_error("Bool Index"); }
-				llvm::Value *indexVal = IndexExpr->Codegen();
+				llvm::Value *indexVal = IndexExpr->Codegen(c);
 				llvm::Value *Index = indexVal; // access Foo[8]
-				llvm::Value *ArrayIndex = Builder.CreateGEP(ArrayLoc, Index, "arrayindex");
+				llvm::Value *ArrayIndex = c.Builder.CreateGEP(ArrayLoc, Index, "arrayindex");
 
 				llvm::Value *val;
-				val = Builder.CreateLoad(ArrayIndex);
+				val = c.Builder.CreateLoad(ArrayIndex);
 				val->setName(Name);
 				return val;
-				//return Builder.CreateLoad(ArrayIndex);  
+				//return c.Builder.CreateLoad(ArrayIndex);  
 			} 
 		}
 		return NULL;
@@ -705,35 +1160,42 @@ class AssignVarAST : public decafAST
 	decafAST* Expr;
 public: 
 	AssignVarAST(ValueVariableExprAST* value, decafAST* expr) : Value(value), Expr(expr) {}
-	string str() {
-		return string("AssignVar") + "(" + Value->getID() + "," + getString(Expr) + ")";
+	void print(decaf_printer &out) {
+		out << "AssignVar(" << Value->getID() << ",";
+		out.node(Expr);
+		out << ")";
 	}
 	string getName(){
 		return Value->getID();
 	}
-	llvm::Value *Codegen() {
+	void Resolve(decaf_compiler &c) {
+		Value->Resolve(c);
+		Expr->Resolve(c);
+		noteAccess(c, Value->getDecl(), true);
+	}
+	llvm::Value *Codegen(decaf_compiler &c) {
 		llvm::Value *val = NULL;
 		descriptor *d;
-		d = access_symtbl(Value->getID());
+		d = Value->getDecl();
 
 		llvm::AllocaInst *Alloca = NULL;
-		if(d != NULL){
+		if(d != NULL && d->kind == DESC_LOCAL){
 			Alloca = d->alloca_ptr;
 		}
 
 		llvm::GlobalVariable *global = NULL;
-		if(d != NULL){
+		if(d != NULL && d->kind == DESC_GLOBAL){
 			global = d->global_ptr;
 		}
 
-		llvm::Value *rvalue = Expr->Codegen();
+		llvm::Value *rvalue = Expr->Codegen(c);
 
 
 			if(global != NULL) {
-				val = Builder.CreateStore(rvalue, global);
+				val = c.Builder.CreateStore(rvalue, global);
 			}
 			else if(Alloca != NULL) {
-				val = Builder.CreateStore(rvalue, Alloca);
+				val = c.Builder.CreateStore(rvalue, Alloca);
 			}
 		return NULL;
 	}
@@ -745,374 +1207,470 @@ class AssignArrayAST : public decafAST
 	decafAST* Expr;
 public: 
 	AssignArrayAST(ValueArrayLocExprAST* value, decafAST* expr) : Value(value), Expr(expr) {}
-	string str() {
-		return string("AssignArrayLoc") + "(" + Value->getID() + "," + getString(Value->getIndexExpr()) + "," + getString(Expr) + ")";
+	void print(decaf_printer &out) {
+		out << "AssignArrayLoc(" << Value->getID() << ",";
+		out.node(Value->getIndexExpr());
+		out << ",";
+		out.node(Expr);
+		out << ")";
+	}
+	void Resolve(decaf_compiler &c) {
+		Value->Resolve(c);
+		Expr->Resolve(c);
+		if(Value->getDecl()->kind != DESC_GLOBAL) {
+			throw runtime_error("array " + Value->getID() + " is not a global");
+		}
+		noteAccess(c, Value->getDecl(), true);
 	}
-	llvm::Value *Codegen() {
+	llvm::Value *Codegen(decaf_compiler &c) {
 		descriptor *d;
-		d = access_symtbl(Value->getID());
+		d = Value->getDecl();
 
 		llvm::GlobalVariable *global;
 		global = d->global_ptr;
 
-		llvm::Value *rvalue = Expr->Codegen();
+		llvm::Value *rvalue = Expr->Codegen(c);
 
 		const llvm::PointerType *ptrTy = rvalue->getType()->getPointerTo();
 		if(ptrTy == global->getType()){
 			return NULL;
 		}
 
-		llvm::Value *val = Expr->Codegen();
-		llvm::Value *indexVal = Value->getIndexVal();
+		llvm::Value *indexVal = Value->getIndexVal(c);
 
-		llvm::Value *ArrayLoc = Builder.CreateStructGEP(global, 0, "arrayloc");
+		llvm::Value *ArrayLoc = c.Builder.CreateStructGEP(global, 0, "arrayloc");
 		llvm::Value *Index = indexVal; // access Foo[8]
-		llvm::Value *ArrayIndex = Builder.CreateGEP(ArrayLoc, Index, "arrayindex");
-		llvm::Value *ArrayStore = Builder.CreateStore(val, ArrayIndex); // Foo[8] = 1
+		llvm::Value *ArrayIndex = c.Builder.CreateGEP(ArrayLoc, Index, "arrayindex");
+		llvm::Value *ArrayStore = c.Builder.CreateStore(rvalue, ArrayIndex); // Foo[8] = 1
 		return ArrayStore;
 	}
 };
 
-class IfAST : public decafAST {
+class IfAST : public decafCompoundAST {
 	decafAST *Condition;
 	BlockAST *If_Block;
 	BlockAST *Else_Block;
+	llvm::BasicBlock *IfFalseBB; // set by the first codegen step for the later ones
+	llvm::BasicBlock *IfEndBB;
+	bool hasElse() { return Else_Block != NULL && !Else_Block->empty(); }
 public:
-	IfAST(decafAST *cond, BlockAST *ifblock, BlockAST *elseblock) : Condition(cond), If_Block(ifblock), Else_Block(elseblock) {}
-	string str() {
-		return string("IfStmt") + "(" + getString(Condition) + "," + getString(If_Block) + "," + getString(Else_Block) + ")";
-	}
-	llvm::Value *Codegen(){
-//		symbol_table syms;
-//		symtbl.push_front(syms);
-
-		llvm::BasicBlock *CurBB = Builder.GetInsertBlock();
-		llvm::Function *func = CurBB->getParent();
-
-		llvm::BasicBlock* IfStartBB = llvm::BasicBlock::Create(TheContext, "ifstart", func);
-		llvm::BasicBlock* IfTrueBB = llvm::BasicBlock::Create(TheContext, "iftrue",  func);
-		llvm::BasicBlock* IfFalseBB = llvm::BasicBlock::Create(TheContext, "iffalse", func);
-		llvm::BasicBlock* IfEndBB = llvm::BasicBlock::Create(TheContext, "ifend", func);
-
-		descriptor* d1 = new descriptor;
-		d1->block_ptr = IfStartBB;
-		(symtbl.front())["ifstart"]  = d1;
-
-		descriptor* d2 = new descriptor;
-		d2->block_ptr = IfTrueBB;
-		(symtbl.front())["iftrue"]  = d2;
-
-		descriptor* d3 = new descriptor;
-		d3->block_ptr = IfFalseBB;
-		(symtbl.front())["iffalse"]  = d3;
-
-		descriptor* d4 = new descriptor;
-		d4->block_ptr = IfEndBB;
-		(symtbl.front())["ifend"]  = d4;
-
-		Builder.CreateBr(IfStartBB);
-		Builder.SetInsertPoint(IfStartBB);
-		llvm::Value* Cond = Condition->Codegen();   
-		Builder.CreateCondBr(Cond, IfTrueBB, IfFalseBB);
-
-		Builder.SetInsertPoint(IfTrueBB);
-		If_Block->Codegen();
-		Builder.CreateBr(IfEndBB);
-
-		Builder.SetInsertPoint(IfFalseBB);
-		if(Else_Block != NULL){
-			Else_Block->Codegen();
+	IfAST(decafAST *cond, BlockAST *ifblock, BlockAST *elseblock) : Condition(cond), If_Block(ifblock), Else_Block(elseblock), IfFalseBB(NULL), IfEndBB(NULL) {}
+	void print(decaf_printer &out) {
+		out << "IfStmt(";
+		out.node(Condition);
+		out << ",";
+		out.node(If_Block);
+		out << ",";
+		out.node(Else_Block);
+		out << ")";
+	}
+	decafAST *resolveStep(decaf_compiler &c, int step) {
+		switch(step) {
+		case 0:
+			Condition->Resolve(c);
+			return If_Block;
+		case 1:
+			return Else_Block;
+		}
+		return NULL;
+	}
+	decafAST *codegenStep(decaf_compiler &c, int step) {
+		switch(step) {
+		case 0: {
+			// the blocks are added to the function as code goes into them,
+			// and an empty else gets none
+			llvm::BasicBlock* IfTrueBB = llvm::BasicBlock::Create(c.TheContext, "iftrue");
+			IfEndBB = llvm::BasicBlock::Create(c.TheContext, "ifend");
+			IfFalseBB = hasElse() ? llvm::BasicBlock::Create(c.TheContext, "iffalse") : IfEndBB;
+
+			llvm::Value* Cond = Condition->Codegen(c);
+			c.Builder.CreateCondBr(Cond, IfTrueBB, IfFalseBB);
+
+			startBlock(c, IfTrueBB);
+			return If_Block;
+		}
+		case 1:
+			if(!blockTerminated(c)) { c.Builder.CreateBr(IfEndBB); }
+			if(hasElse()) {
+				startBlock(c, IfFalseBB);
+				return Else_Block;
+			}
+			break;
+		case 2:
+			if(!blockTerminated(c)) { c.Builder.CreateBr(IfEndBB); }
+			break;
+		}
+		// when both branches return, break or continue nothing reaches
+		// the end, and the code after the if is left out
+		if(IfEndBB->hasNPredecessors(0)) {
+			delete IfEndBB;
+		} else {
+			startBlock(c, IfEndBB);
 		}
-		Builder.CreateBr(IfEndBB);
-		
-		Builder.SetInsertPoint(IfEndBB);
-//		symtbl.pop_front();
 		return NULL;
   	}
 };
 
-class WhileAST : public decafAST {
+/// LoopAST - while and for loops, the targets of continue and break
+class LoopAST : public decafCompoundAST {
+protected:
+	llvm::BasicBlock *ContinueBB;
+	llvm::BasicBlock *BreakBB;
+public:
+	LoopAST() : ContinueBB(NULL), BreakBB(NULL) {}
+	llvm::BasicBlock *getContinueBlock() { return ContinueBB; }
+	llvm::BasicBlock *getBreakBlock() { return BreakBB; }
+};
+
+class WhileAST : public LoopAST {
 	decafAST *Condition;
-	decafStmtList *Block;
+	BlockAST *Block;
 public:
-	WhileAST(decafAST *cond, decafStmtList *block) : Condition(cond), Block(block) {}
-	string str() {
-		return string("WhileStmt") + "(" + getString(Condition) + "," + getString(Block) + ")";
+	WhileAST(decafAST *cond, BlockAST *block) : Condition(cond), Block(block) {}
+	void print(decaf_printer &out) {
+		out << "WhileStmt(";
+		out.node(Condition);
+		out << ",";
+		out.node(Block);
+		out << ")";
+	}
+	decafAST *resolveStep(decaf_compiler &c, int step) {
+		if(step == 0) {
+			Condition->Resolve(c);
+			c.effects->hasLoops = true;
+			c.enclosingLoops.push_back(this);
+			return Block;
+		}
+		c.enclosingLoops.pop_back();
+		return NULL;
 	}
-	llvm::Value *Codegen(){
-		symbol_table syms;
-		symtbl.push_front(syms);
-
-		llvm::BasicBlock *CurBB = Builder.GetInsertBlock();
-		llvm::Function *func = CurBB->getParent();
-	
-		llvm::BasicBlock* WhileStartBB = llvm::BasicBlock::Create(TheContext, "whilestart", func);
-		llvm::BasicBlock* WhileTrueBB  = llvm::BasicBlock::Create(TheContext, "whiletrue",  func);
-		llvm::BasicBlock* WhileEndBB   = llvm::BasicBlock::Create(TheContext, "whileend", func);     
-
-		descriptor* d1 = new descriptor;
-		d1->block_ptr = WhileStartBB;
-		(symtbl.front())["loopstart"] = d1;
-
-		descriptor* d2 = new descriptor;
-		d2->block_ptr = WhileTrueBB;
-		(symtbl.front())["looptrue"] = d2; 
-
-		descriptor* d3 = new descriptor;
-		d3->block_ptr = WhileEndBB;
-		(symtbl.front())["loopend"] = d3;
-
-		Builder.CreateBr(WhileStartBB);
-		Builder.SetInsertPoint(WhileStartBB);
-		llvm::Value* Cond = Condition->Codegen(); 
-		Builder.CreateCondBr(Cond, WhileTrueBB, WhileEndBB);
+	decafAST *codegenStep(decaf_compiler &c, int step) {
+		if(step == 0) {
+			llvm::BasicBlock *CurBB = c.Builder.GetInsertBlock();
+			llvm::Function *func = CurBB->getParent();
 		
-		Builder.SetInsertPoint(WhileTrueBB);
-		Block->Codegen();
-		Builder.CreateBr(WhileStartBB);
+			llvm::BasicBlock* WhileStartBB = llvm::BasicBlock::Create(c.TheContext, "whilestart", func);
+			llvm::BasicBlock* WhileTrueBB  = llvm::BasicBlock::Create(c.TheContext, "whiletrue",  func);
+			llvm::BasicBlock* WhileEndBB   = llvm::BasicBlock::Create(c.TheContext, "whileend", func);     
+
+			ContinueBB = WhileStartBB;
+			BreakBB = WhileEndBB;
+
+			c.Builder.CreateBr(WhileStartBB);
+			c.Builder.SetInsertPoint(WhileStartBB);
+			llvm::Value* Cond = Condition->Codegen(c); 
+			c.Builder.CreateCondBr(Cond, WhileTrueBB, WhileEndBB);
+			
+			c.Builder.SetInsertPoint(WhileTrueBB);
+			return Block;
+		}
+		if(!blockTerminated(c)) { c.Builder.CreateBr(ContinueBB); }
 
-		Builder.SetInsertPoint(WhileEndBB);
-		symtbl.pop_front();
+		c.Builder.SetInsertPoint(BreakBB);
 		return NULL;
 	}
 };
 
-class ForAST : public decafAST {
+class ForAST : public LoopAST {
 	decafStmtList *PreAssignList;
 	decafAST *Condition;
 	decafStmtList *LoopAssignList;
-	decafAST *Block;
+	BlockAST *Block;
+	llvm::BasicBlock *ForStartBB; // set by the first codegen step for the second
 public:
-	ForAST(decafStmtList *pre, decafAST *cond, decafStmtList *loop, decafAST *b) : PreAssignList(pre), Condition(cond), LoopAssignList(loop), Block(b) {}
-	string str() {
-		return string("ForStmt") + "(" + getString(PreAssignList) + "," + getString(Condition) + "," + getString(LoopAssignList) + "," + getString(Block) + ")";
+	ForAST(decafStmtList *pre, decafAST *cond, decafStmtList *loop, BlockAST *b) : PreAssignList(pre), Condition(cond), LoopAssignList(loop), Block(b), ForStartBB(NULL) {}
+	void print(decaf_printer &out) {
+		out << "ForStmt(";
+		out.node(PreAssignList);
+		out << ",";
+		out.node(Condition);
+		out << ",";
+		out.node(LoopAssignList);
+		out << ",";
+		out.node(Block);
+		out << ")";
+	}
+	decafAST *resolveStep(decaf_compiler &c, int step) {
+		if(step == 0) {
+			PreAssignList->Resolve(c);
+			Condition->Resolve(c);
+			LoopAssignList->Resolve(c);
+			c.effects->hasLoops = true;
+			c.enclosingLoops.push_back(this);
+			return Block;
+		}
+		c.enclosingLoops.pop_back();
+		return NULL;
 	}
-	llvm::Value *Codegen(){
-		symbol_table syms;
-		symtbl.push_front(syms);
-
-		llvm::BasicBlock *CurBB = Builder.GetInsertBlock();
-		llvm::Function *func = CurBB->getParent();
-		
-		llvm::BasicBlock* ForStartBB = llvm::BasicBlock::Create(TheContext, "forstart", func);
-		llvm::BasicBlock* ForTrueBB  = llvm::BasicBlock::Create(TheContext, "fortrue",  func);
-		llvm::BasicBlock* ForPostBB  = llvm::BasicBlock::Create(TheContext, "forpost",  func);
-		llvm::BasicBlock* ForEndBB   = llvm::BasicBlock::Create(TheContext, "forend",   func);     
+	decafAST *codegenStep(decaf_compiler &c, int step) {
+		if(step == 0) {
+			llvm::BasicBlock *CurBB = c.Builder.GetInsertBlock();
+			llvm::Function *func = CurBB->getParent();
+			
+			ForStartBB = llvm::BasicBlock::Create(c.TheContext, "forstart", func);
+			llvm::BasicBlock* ForTrueBB  = llvm::BasicBlock::Create(c.TheContext, "fortrue",  func);
+			llvm::BasicBlock* ForPostBB  = llvm::BasicBlock::Create(c.TheContext, "forpost",  func);
+			llvm::BasicBlock* ForEndBB   = llvm::BasicBlock::Create(c.TheContext, "forend",   func);     
 
-		descriptor* d1 = new descriptor;
-		d1->block_ptr = ForStartBB;
-		(symtbl.front())["loopassign"]  = d1;
+			ContinueBB = ForPostBB;
+			BreakBB = ForEndBB;
 
-		descriptor* d2 = new descriptor;
-		d2->block_ptr = ForTrueBB;
-		(symtbl.front())["looptrue"]   = d2; 
+			PreAssignList->Codegen(c);
 
-		descriptor* d3 = new descriptor;
-		d3->block_ptr = ForPostBB;
-		(symtbl.front())["loopstart"] = d3;
+			c.Builder.CreateBr(ForStartBB);
+			c.Builder.SetInsertPoint(ForStartBB);
+			llvm::Value* Cond = Condition->Codegen(c);
+			c.Builder.CreateCondBr(Cond, ForTrueBB, ForEndBB);
 
-		descriptor* d4 = new descriptor;
-		d4->block_ptr = ForEndBB;
-		(symtbl.front())["loopend"]    = d4;
-
-		PreAssignList->Codegen();
-
-		Builder.CreateBr(ForStartBB);
-		Builder.SetInsertPoint(ForStartBB);
-		llvm::Value* Cond = Condition->Codegen();
-		Builder.CreateCondBr(Cond, ForTrueBB, ForEndBB);
+			c.Builder.SetInsertPoint(ForTrueBB);
+			return Block;
+		}
+		if(!blockTerminated(c)) { c.Builder.CreateBr(ContinueBB); }
 
-		Builder.SetInsertPoint(ForTrueBB);
-		Block->Codegen();
-		Builder.CreateBr(ForPostBB);
-	
-		Builder.SetInsertPoint(ForPostBB); 
-		LoopAssignList->Codegen();
-		Builder.CreateBr(ForStartBB);
+		// no loop assignments when the body always returns or breaks
+		if(ContinueBB->hasNPredecessors(0)) {
+			ContinueBB->eraseFromParent();
+		} else {
+			c.Builder.SetInsertPoint(ContinueBB);
+			LoopAssignList->Codegen(c);
+			c.Builder.CreateBr(ForStartBB);
+		}
 
-		Builder.SetInsertPoint(ForEndBB);
-		symtbl.pop_front();
+		c.Builder.SetInsertPoint(BreakBB);
 		return NULL;
 	}
 };
 
 class ContinueAST : public decafAST
 {  
+	LoopAST *Loop;
 public: 
-	ContinueAST() {}
-	string str()
+	ContinueAST() : Loop(NULL) {}
+	void print(decaf_printer &out) {
+		out << "ContinueStmt";
+	}
+	void Resolve(decaf_compiler &c)
 	{
-		return string("ContinueStmt");
+		if(c.enclosingLoops.empty()) { throw runtime_error("continue outside of a loop"); }
+		Loop = c.enclosingLoops.back();
 	}
-	llvm::Value *Codegen() 
+	llvm::Value *Codegen(decaf_compiler &c) 
 	{
-		llvm::BasicBlock *CurBB = Builder.GetInsertBlock();
-		llvm::Function *func = CurBB->getParent();
-
-		descriptor *d;
-		d = access_symtbl("loopstart");
-		llvm::BasicBlock* StartBB = d->block_ptr;
-		if(StartBB != NULL)
-		{
-			Builder.CreateBr(StartBB);
-			llvm::BasicBlock* idk = llvm::BasicBlock::Create(TheContext, "idk", func);
-			Builder.SetInsertPoint(idk);
-		}
-		return NULL;
+		return c.Builder.CreateBr(Loop->getContinueBlock());
 	}
 };
 
 class BreakAST : public decafAST
 {  
+	LoopAST *Loop;
 public: 
-	BreakAST() {}
-	string str()
+	BreakAST() : Loop(NULL) {}
+	void print(decaf_printer &out) {
+		out << "BreakStmt";
+	}
+	void Resolve(decaf_compiler &c)
 	{
-		return string("BreakStmt");
+		if(c.enclosingLoops.empty()) { throw runtime_error("break outside of a loop"); }
+		Loop = c.enclosingLoops.back();
 	}
-	llvm::Value *Codegen() 
+	llvm::Value *Codegen(decaf_compiler &c) 
 	{
-		llvm::BasicBlock *CurBB = Builder.GetInsertBlock();
-		llvm::Function *func = CurBB->getParent();
-
-		descriptor *d;
-		d = access_symtbl("loopend");
-		llvm::BasicBlock* EndBB = d->block_ptr;
-		if(EndBB != NULL)
-		{
-			Builder.CreateBr(EndBB);
-			llvm::BasicBlock* idk = llvm::BasicBlock::Create(TheContext, "idk", func);
-			Builder.SetInsertPoint(idk);
-		}
-		return NULL;
+		return c.Builder.CreateBr(Loop->getBreakBlock());
 	}
 };
 
 class ReturnAST : public decafAST {
-	decafStmtList *Expr;
+	decafAST *Expr;
 public:
-	ReturnAST(decafStmtList *expr) : Expr(expr) {}
-	string str() {
-		return string("ReturnStmt") + "(" + getString(Expr) + ")";
-	}
-	llvm::Value *Codegen(){
-		llvm::Value* val;
-		llvm::BasicBlock *CurrBB = Builder.GetInsertBlock();
-		llvm::Function *func = CurrBB->getParent();
-		llvm::Type* returnTy = func->getReturnType();
-		val = getZeroInit("IntType");
-	
-		if(Expr != NULL)
-		{
-			val = Expr->Codegen();
-			Builder.CreateRet(val);
+	ReturnAST(decafAST *expr) : Expr(expr) {}
+	void print(decaf_printer &out) {
+		out << "ReturnStmt(";
+		out.node(Expr);
+		out << ")";
+	}
+	void Resolve(decaf_compiler &c) {
+		if(Expr != NULL) { Expr->Resolve(c); }
+	}
+	// a return without a value returns the default value, as falling off
+	// the end of the method does
+	llvm::Value *Codegen(decaf_compiler &c){
+		llvm::Type* returnTy = c.Builder.GetInsertBlock()->getParent()->getReturnType();
+		if(Expr != NULL) {
+			return c.Builder.CreateRet(Expr->Codegen(c));
 		}
-		return val;
+		if(returnTy->isVoidTy()) {
+			return c.Builder.CreateRetVoid();
+		}
+		return c.Builder.CreateRet(llvm::Constant::getNullValue(returnTy));
 	}
 };
 
-llvm::Value* short_circuit_and(decafAST *LeftValue, decafAST *RightValue){
-    llvm::Function *func = Builder.GetInsertBlock()->getParent();
-    llvm::BasicBlock *and_right = llvm::BasicBlock::Create(TheContext, "andright",func);
-    llvm::BasicBlock *and_end = llvm::BasicBlock::Create(TheContext, "andend",func);
-
-    llvm::Value *left = LeftValue->Codegen();
-    llvm::BasicBlock *CurBB = Builder.GetInsertBlock();
-    Builder.CreateCondBr(left, and_right, and_end);
-
-    Builder.SetInsertPoint(and_right);
-    llvm::Value *right = RightValue->Codegen();
-    llvm::Value *res = Builder.CreateAnd(left, right, "andtemp");
-    llvm::BasicBlock *after = Builder.GetInsertBlock();
-    Builder.CreateBr(and_end);
-
-    Builder.SetInsertPoint(and_end);
-    llvm::PHINode *val = Builder.CreatePHI(Builder.getInt1Ty(), 2, "phival");
-    val->addIncoming(left, CurBB);
-    val->addIncoming(res, after);
-
-    return val;
-}
-
-llvm::Value* short_circuit_or(decafAST *LeftValue, decafAST *RightValue){
-    llvm::Function *func = Builder.GetInsertBlock()->getParent();
-    llvm::BasicBlock *or_right = llvm::BasicBlock::Create(TheContext, "orright",func);
-    llvm::BasicBlock *or_end = llvm::BasicBlock::Create(TheContext, "orend",func);
-
-    llvm::Value *left = LeftValue->Codegen();
-    llvm::BasicBlock *CurBB = Builder.GetInsertBlock();
-    Builder.CreateCondBr(left, or_end, or_right);
-
-    Builder.SetInsertPoint(or_right);
-    llvm::Value *right = RightValue->Codegen();
-    llvm::Value *res = Builder.CreateOr(left, right, "ortemp");
-    llvm::BasicBlock *after = Builder.GetInsertBlock();
-    Builder.CreateBr(or_end);
-
-    Builder.SetInsertPoint(or_end);
-    llvm::PHINode *val = Builder.CreatePHI(Builder.getInt1Ty(), 2, "phival");
-    val->addIncoming(left, CurBB);
-    val->addIncoming(res, after);
-
-    return val;
-}
+// lowering of the arithmetic and comparison operators, indexed by decafOp.
+// And/Or are short-circuited and the unary operators are lowered by
+// OperatorExpr::Codegen.
+static const struct {
+	bool isCmp;
+	llvm::Instruction::BinaryOps opcode;
+	llvm::CmpInst::Predicate predicate;
+	const char *tmpName;
+} binaryLowering[] = {
+	{ false, llvm::Instruction::Add,  llvm::CmpInst::BAD_ICMP_PREDICATE, "addtmp" }, // Plus
+	{ false, llvm::Instruction::Sub,  llvm::CmpInst::BAD_ICMP_PREDICATE, "subtmp" }, // Minus
+	{ false, llvm::Instruction::Mul,  llvm::CmpInst::BAD_ICMP_PREDICATE, "multmp" }, // Mult
+	{ false, llvm::Instruction::SDiv, llvm::CmpInst::BAD_ICMP_PREDICATE, "divtmp" }, // Div
+	{ false, llvm::Instruction::Shl,  llvm::CmpInst::BAD_ICMP_PREDICATE, "lstmp"  }, // Leftshift
+	{ false, llvm::Instruction::LShr, llvm::CmpInst::BAD_ICMP_PREDICATE, "rstmp"  }, // Rightshift
+	{ false, llvm::Instruction::SRem, llvm::CmpInst::BAD_ICMP_PREDICATE, "remtmp" }, // Mod
+	{ true,  llvm::Instruction::BinaryOpsEnd, llvm::CmpInst::ICMP_SLT, "lttmp"  }, // Lt
+	{ true,  llvm::Instruction::BinaryOpsEnd, llvm::CmpInst::ICMP_SGT, "gttmp"  }, // Gt
+	{ true,  llvm::Instruction::BinaryOpsEnd, llvm::CmpInst::ICMP_SLE, "leqtmp" }, // Leq
+	{ true,  llvm::Instruction::BinaryOpsEnd, llvm::CmpInst::ICMP_SGE, "geqtmp" }, // Geq
+	{ true,  llvm::Instruction::BinaryOpsEnd, llvm::CmpInst::ICMP_EQ,  "eqtmp"  }, // Eq
+	{ true,  llvm::Instruction::BinaryOpsEnd, llvm::CmpInst::ICMP_NE,  "neqtmp" }, // Neq
+};
 
-class BinaryExpr : public decafAST {
-	string BinaryOperator;
-	decafAST *LeftValue;
+/// OperatorExpr - BinaryExpr and UnaryExpr. Generated programs chain
+/// tens of thousands of operators (a+b+c+...), which the parser reduces
+/// without growing its stack, so a tree of operators is resolved and
+/// generated from an explicit stack rather than by recursing once per
+/// operator. Only the operands that are not operators are called.
+class OperatorExpr : public decafAST {
+protected:
+	decafOp Operator;
+	decafAST *LeftValue;  // NULL for a unary operator
 	decafAST *RightValue;
+	OperatorExpr(decafOp op, decafAST *l, decafAST *r) : Operator(op), LeftValue(l), RightValue(r) {}
 public:
-	BinaryExpr(string op, decafAST *l, decafAST *r) : BinaryOperator(op), LeftValue(l), RightValue(r) {}
-	string str() {
-		return string("BinaryExpr") + "(" + BinaryOperator + "," + getString(LeftValue) + "," + getString(RightValue) + ")";
-	}
-	llvm::Value *Codegen(){
-		llvm::Value* val;
-		if( (BinaryOperator == "And") ){
-			return short_circuit_and(LeftValue,RightValue);
+	void Resolve(decaf_compiler &c) {
+		std::vector<decafAST *> work(1, this);
+		while (!work.empty()) {
+			decafAST *e = work.back();
+			work.pop_back();
+			OperatorExpr *op = dynamic_cast<OperatorExpr *>(e);
+			if (op == NULL) {
+				e->Resolve(c);
+				continue;
+			}
+			// left to right, as the errors are reported in that order
+			work.push_back(op->RightValue);
+			if (op->LeftValue != NULL) { work.push_back(op->LeftValue); }
 		}
-		else if( (BinaryOperator == "Or") ){
-			return short_circuit_or(LeftValue,RightValue);
+	}
+	llvm::Value *Codegen(decaf_compiler &c);
+};
+
+// an operator whose code is being generated: step 0 comes before its
+// left operand, step 1 between the operands and step 2 after the right
+// one. && and || branch around the right operand, from leftBB to endBB.
+struct operator_frame {
+	OperatorExpr *op;
+	int step;
+	llvm::BasicBlock *leftBB, *rightBB, *endBB;
+};
+
+llvm::Value *OperatorExpr::Codegen(decaf_compiler &c) {
+	std::vector<operator_frame> open;
+	std::vector<llvm::Value *> values; // of the operands generated so far
+	operator_frame root = { this, 0, NULL, NULL, NULL };
+	open.push_back(root);
+	while (!open.empty()) {
+		operator_frame &f = open.back();
+		OperatorExpr *e = f.op;
+		bool shortCircuit = (e->Operator == OP_AND || e->Operator == OP_OR);
+		decafAST *next = NULL;
+		switch (f.step++) {
+		case 0:
+			if (e->LeftValue == NULL) {
+				f.step = 2;
+				next = e->RightValue;
+				break;
+			}
+			if (shortCircuit) {
+				llvm::Function *func = c.Builder.GetInsertBlock()->getParent();
+				bool isAnd = (e->Operator == OP_AND);
+				f.rightBB = llvm::BasicBlock::Create(c.TheContext, isAnd ? "andright" : "orright", func);
+				f.endBB = llvm::BasicBlock::Create(c.TheContext, isAnd ? "andend" : "orend", func);
+			}
+			next = e->LeftValue;
+			break;
+		case 1:
+			if (shortCircuit) {
+				f.leftBB = c.Builder.GetInsertBlock();
+				if (e->Operator == OP_AND) {
+					c.Builder.CreateCondBr(values.back(), f.rightBB, f.endBB);
+				} else {
+					c.Builder.CreateCondBr(values.back(), f.endBB, f.rightBB);
+				}
+				c.Builder.SetInsertPoint(f.rightBB);
+			}
+			next = e->RightValue;
+			break;
+		default: {
+			llvm::Value *RValue = values.back();
+			values.pop_back();
+			llvm::Value *LValue = NULL;
+			if (e->LeftValue != NULL) {
+				LValue = values.back();
+				values.pop_back();
+			}
+			llvm::Value *val;
+			if (e->LeftValue == NULL) {
+				switch(e->Operator) {
+				case OP_NOT:        val = c.Builder.CreateNot(RValue, "nottmp"); break;
+				case OP_UNARYMINUS: val = c.Builder.CreateNeg(RValue, "negtmp"); break;
+				default:            val = NULL; break;
+				}
+			} else if (shortCircuit) {
+				llvm::Value *res = (e->Operator == OP_AND) ? c.Builder.CreateAnd(LValue, RValue, "andtemp")
+				                                          : c.Builder.CreateOr(LValue, RValue, "ortemp");
+				llvm::BasicBlock *after = c.Builder.GetInsertBlock();
+				c.Builder.CreateBr(f.endBB);
+
+				c.Builder.SetInsertPoint(f.endBB);
+				llvm::PHINode *phi = c.Builder.CreatePHI(c.Builder.getInt1Ty(), 2, "phival");
+				phi->addIncoming(LValue, f.leftBB);
+				phi->addIncoming(res, after);
+				val = phi;
+			} else if (binaryLowering[e->Operator].isCmp) {
+				val = c.Builder.CreateICmp(binaryLowering[e->Operator].predicate, LValue, RValue, binaryLowering[e->Operator].tmpName);
+			} else {
+				val = c.Builder.CreateBinOp(binaryLowering[e->Operator].opcode, LValue, RValue, binaryLowering[e->Operator].tmpName);
+			}
+			open.pop_back();
+			values.push_back(val);
+			continue;
 		}
-		else{
-			llvm::Value* LValue = LeftValue->Codegen();
-			llvm::Value* RValue = RightValue->Codegen();
-		
-		if(BinaryOperator == "Plus")       { val = Builder.CreateAdd(LValue,RValue,"addtmp");  }
-		if(BinaryOperator == "Minus")      { val = Builder.CreateSub(LValue,RValue,"subtmp");  }
-		if(BinaryOperator == "Mult")       { val = Builder.CreateMul(LValue,RValue,"multmp");  }
-		if(BinaryOperator == "Div")        { val = Builder.CreateSDiv(LValue,RValue,"divtmp"); }
-		if(BinaryOperator == "Leftshift")  { val = Builder.CreateShl(LValue, RValue,"lstmp");  }
-		if(BinaryOperator == "Rightshift") { val = Builder.CreateLShr(LValue, RValue,"rstmp");  }
-		if(BinaryOperator == "Mod")        { val = Builder.CreateSRem(LValue, RValue,"remtmp");  } 
-		if(BinaryOperator == "Lt")         { val = Builder.CreateICmpSLT(LValue, RValue,"lttmp");  }
-		if(BinaryOperator == "Gt")         { val = Builder.CreateICmpSGT(LValue, RValue,"gttmp");  }
-		if(BinaryOperator == "Leq")        { val = Builder.CreateICmpSLE(LValue, RValue,"leqtmp");  }
-		if(BinaryOperator == "Geq")        { val = Builder.CreateICmpSGE(LValue, RValue,"geqtmp");  }
-//		if(BinaryOperator == "And")        { val = Builder.CreateAnd(LValue, RValue,"andtmp");  }
-//		if(BinaryOperator == "Or")         { val = Builder.CreateOr(LValue, RValue,"ortmp");  }
-		if(BinaryOperator == "Eq")         { val = Builder.CreateICmpEQ(LValue, RValue,"eqtmp");  }
-		if(BinaryOperator == "Neq")        { val = Builder.CreateICmpNE(LValue, RValue,"neqtmp"); }
-		return val;
 		}
-		return val;
+		OperatorExpr *op = dynamic_cast<OperatorExpr *>(next);
+		if (op != NULL) {
+			operator_frame nested = { op, 0, NULL, NULL, NULL };
+			open.push_back(nested);
+		} else {
+			values.push_back(next->Codegen(c));
+		}
+	}
+	return values.back();
+}
+
+class BinaryExpr : public OperatorExpr {
+public:
+	BinaryExpr(decafOp op, decafAST *l, decafAST *r) : OperatorExpr(op, l, r) {}
+	void print(decaf_printer &out) {
+		out << "BinaryExpr(" << opName[Operator] << ",";
+		out.node(LeftValue);
+		out << ",";
+		out.node(RightValue);
+		out << ")";
 	}
 };
 
-class UnaryExpr : public decafAST {
-	string UnaryOperator;
-	decafAST *Expr;
+class UnaryExpr : public OperatorExpr {
 public:
-	UnaryExpr(string op, decafAST *e) : UnaryOperator(op), Expr(e){}
-	string str() {
-		return string("UnaryExpr") + "(" + UnaryOperator + "," + getString(Expr) + ")";
-	}
-	llvm::Value *Codegen(){
-		llvm::Value* val;
-		llvm::Value* RValue = Expr->Codegen();
-		if(UnaryOperator == "Not")        { val = Builder.CreateNot(RValue, "nottmp");  } 
-		if(UnaryOperator == "UnaryMinus") { val = Builder.CreateNeg(RValue, "negtmp");  }
-		return val;
+	UnaryExpr(decafOp op, decafAST *e) : OperatorExpr(op, NULL, e) {}
+	void print(decaf_printer &out) {
+		out << "UnaryExpr(" << opName[Operator] << ",";
+		out.node(RightValue);
+		out << ")";
 	}
 };
 
@@ -1172,11 +1730,11 @@ class StringConstantAST : public decafAST {
 	string value;
 public:
 	StringConstantAST(string v) : value(v) {}
-	string str() {
-		return string("StringConstant") + "(" + value + ")";
+	void print(decaf_printer &out) {
+		out << "StringConstant(" << value << ")";
 	}
-	llvm::Value *Codegen(){
-		llvm::GlobalVariable *GS = Builder.CreateGlobalString(removeChar(value.substr(1, value.size() - 2), '\\'), "globalstring");
-		return Builder.CreateConstGEP2_32(GS->getValueType(), GS, 0, 0, "cast");
+	llvm::Value *Codegen(decaf_compiler &c){
+		llvm::GlobalVariable *GS = c.Builder.CreateGlobalString(removeChar(value.substr(1, value.size() - 2), '\\'), "globalstring");
+		return c.Builder.CreateConstGEP2_32(GS->getValueType(), GS, 0, 0, "cast");
 	}
 };
@@ -1,36 +1,50 @@
 %{
 #include <iostream>
+#include <fstream>
 #include <ostream>
 #include <string>
 #include <cstdlib>
 #include "decafcomp-defs.h"
-
-int yylex(void);
-int yyerror(char *); 
-
-// print AST?
-bool printAST = false;
+#include "llvm/IR/LegacyPassManager.h"
+#include "llvm/Pass.h"
+#include "llvm/Transforms/InstCombine/InstCombine.h"
+#include "llvm/Transforms/Scalar.h"
+#include "llvm/Transforms/Scalar/GVN.h"
+#include "llvm/Transforms/Utils.h"
 
 using namespace std;
 
-// this global variable contains all the generated code
-static llvm::Module *TheModule;
-
-// this is the method used to construct the LLVM intermediate code (IR)
-static llvm::LLVMContext TheContext;
-static llvm::IRBuilder<> Builder(TheContext);
-// the calls to TheContext in the init above and in the
-// following code ensures that we are incrementally generating
-// instructions in the right order
+// the module, the IR builder and everything else a compilation uses
+// are in the decaf_compiler that yyparse gets, see decafcomp-defs.h
 
 #include "decafcomp.cc"
 
+// the parse stack is on the heap and grows as needed. Nothing after the
+// parse recurses on how deeply blocks and parentheses nest, so allow far
+// more than bison's default of 10000.
+#define YYMAXDEPTH 10000000
+
 %}
 
+// a pure parser with a reentrant scanner, see decafcomp.lex: the
+// parser and the scanner keep their state on the stack and in the
+// yyscan_t, so files can be parsed on different threads
+%define api.pure full
+%locations
+%param {yyscan_t scanner}
+%parse-param {decaf_compiler &compiler}
+
+%code provides {
+int yylex(YYSTYPE *lval, YYLTYPE *lloc, yyscan_t scanner);
+int yyerror(YYLTYPE *loc, yyscan_t scanner, decaf_compiler &compiler, const char *s);
+}
+
 %union{
     class decafAST *ast;
     std::string *sval;
     int ival;
+    decafOp op;
+    decafType type;
     arr s;
     std::vector<std::string> *vecptr;
 
@@ -60,14 +74,14 @@ static llvm::IRBuilder<> Builder(TheContext);
 %token T_VAR
 %token T_ASSIGN
 
-%token <sval> T_VOID
-%token <sval> T_INTTYPE
-%token <sval> T_BOOLTYPE
-%token <sval> T_STRINGTYPE
+%token <type> T_VOID
+%token <type> T_INTTYPE
+%token <type> T_BOOLTYPE
+%token <type> T_STRINGTYPE
 %token <sval> T_TRUE
 %token <sval> T_FALSE
 
-%token <sval> T_PLUS T_MINUS T_DIV T_MULT T_MOD T_EQ T_NEQ T_LEFTSHIFT T_RIGHTSHIFT T_LT T_GT T_LEQ T_GEQ T_AND T_OR T_NOT
+%token <op> T_PLUS T_MINUS T_DIV T_MULT T_MOD T_EQ T_NEQ T_LEFTSHIFT T_RIGHTSHIFT T_LT T_GT T_LEQ T_GEQ T_AND T_OR T_NOT
 
 %left T_OR
 %left T_AND
@@ -82,18 +96,18 @@ static llvm::IRBuilder<> Builder(TheContext);
 %token <sval> T_STRINGCONSTANT
 %token <sval> T_ID
 
-%type <ast> extern_list extern_defn extern_type_list
+%type <ast> extern_list extern_defn extern_type_list extern_types
 %type <ast> decafpackage
 %type <ast> field_decls field_decl
-%type <ast> method_decls method_decl method_parameter_list method_block
+%type <ast> method_decls method_decl method_parameter_list method_parameters method_block
 %type <ast> var_decls var_decl
 %type <ast> statements statement
 
-%type <ast> block assign_list assign method_call method_arg_list method_arg
+%type <ast> block assign_list assign method_call method_arg_list method_args method_arg
 %type <ast> if_stmt for_stmt while_stmt break_stmt continue_stmt return_stmt
 %type <ast> expr constant value_var value_arr
 
-%type <sval> decaf_type extern_type method_type
+%type <type> decaf_type extern_type method_type
 %type <s> array_type
 %type <vecptr> id_list
 
@@ -104,33 +118,28 @@ start: program;
 program: extern_list decafpackage
     { 
         ProgramAST *prog = new ProgramAST((decafStmtList *)$1, (PackageAST *)$2); 
-		if (printAST) {
-			cout << getString(prog) << endl;
+		if (compiler.printAST) {
+			if (compiler.indentAST) {
+				decaf_indent_buf indented(compiler.out.rdbuf());
+				ostream out(&indented);
+				decaf_printer(out).print(prog);
+				out << '\n';
+			} else {
+				decaf_printer(compiler.out).print(prog);
+				compiler.out << '\n';
+			}
+			compiler.out.flush();
 		}
-        try {
-            prog->Codegen();
-        } 
-        catch (std::runtime_error &e) {
-            cout << "semantic error: " << e.what() << endl;
-            //cout << prog->str() << endl; 
-            exit(EXIT_FAILURE);
-        }
-        delete prog;
+        compiler.parsedProgram = prog;
     }
     ;
 
 extern_list: /* extern_list can be empty */
     { decafStmtList *slist = new decafStmtList(); $$ = slist; }
-	| extern_defn extern_list
+	| extern_list extern_defn
     {
-        decafStmtList* slist;
-        if($2 == NULL) {
-            slist = new decafStmtList();
-        }
-        else {
-            slist = (decafStmtList *)$2;
-        }
-        slist->push_front($1);
+        decafStmtList* slist = (decafStmtList *)$1;
+        slist->push_back($2);
         $$ = slist;
     }
     ;
@@ -138,7 +147,7 @@ extern_list: /* extern_list can be empty */
 extern_defn: T_EXTERN T_FUNC T_ID T_LPAREN extern_type_list T_RPAREN method_type T_SEMICOLON
     {
         ExternFunctionAST *externDef;
-        externDef = new ExternFunctionAST(*$3, *$7, (decafStmtList *)$5);
+        externDef = new ExternFunctionAST(*$3, $7, (decafStmtList *)$5, @3.first_line);
         $$ = externDef;
     }
     ;
@@ -147,42 +156,48 @@ extern_type_list:
     {
         $$ = NULL;
     }
-    | extern_type T_COMMA extern_type_list
+    | extern_types
+    { $$ = $1; }
+    | extern_types T_COMMA
+    { $$ = $1; }
+    ;
+
+extern_types: extern_types T_COMMA extern_type
     {
         decafStmtList* elist;
-        ExternVarDefAST *ex = new ExternVarDefAST(*$1);
-        elist = (decafStmtList *)$3;
-        elist->push_front(ex);
+        ExternVarDefAST *ex = new ExternVarDefAST($3);
+        elist = (decafStmtList *)$1;
+        elist->push_back(ex);
         $$ = elist;
     }
     | extern_type
     {
         decafStmtList* elist;
         elist = new decafStmtList();
-        ExternVarDefAST *ex = new ExternVarDefAST(*$1);
-        elist->push_front(ex);
+        ExternVarDefAST *ex = new ExternVarDefAST($1);
+        elist->push_back(ex);
         $$ = elist;
     }
     ;
 
-decafpackage: T_PACKAGE T_ID begin_block end_block
+decafpackage: T_PACKAGE T_ID T_LCB T_RCB
     { $$ = new PackageAST(*$2, new decafStmtList(), new decafStmtList()); delete $2; }
-    | T_PACKAGE T_ID begin_block field_decls method_decls end_block
+    | T_PACKAGE T_ID T_LCB field_decls method_decls T_RCB
     { $$ = new PackageAST(*$2, (decafStmtList*)$4, (decafStmtList*)$5); delete $2; }
     ;
 
 field_decls:
     { $$ = NULL; }
-    | field_decl field_decls
+    | field_decls field_decl
     {
         decafStmtList* slist;
-        if($2 == NULL) {
+        if($1 == NULL) {
             slist = new decafStmtList();
         }
         else {
-            slist = (decafStmtList *)$2;
+            slist = (decafStmtList *)$1;
         }
-        slist->push_front($1);
+        slist->push_back($2);
         $$ = slist;
     }
     ;
@@ -192,7 +207,7 @@ field_decl: T_VAR id_list decaf_type T_SEMICOLON
         decafStmtList* slist = new decafStmtList();
         FieldDeclScalarAST* node;
         for(int i = 0; i < $2->size(); i++) {
-            node = new FieldDeclScalarAST((*$2)[i], *$3);
+            node = new FieldDeclScalarAST((*$2)[i], $3, @2.first_line);
             slist->push_back(node);
         }
         $$ = slist;
@@ -202,14 +217,14 @@ field_decl: T_VAR id_list decaf_type T_SEMICOLON
         decafStmtList* slist = new decafStmtList();
         FieldDeclArrayAST* node;
         for(int i = 0; i < $2->size(); i++) {
-            node = new FieldDeclArrayAST((*$2)[i], *$3.type, *$3.size);
+            node = new FieldDeclArrayAST((*$2)[i], $3.type, *$3.size, @2.first_line);
             slist->push_back(node);
         }
         $$ = slist;
     }
     | T_VAR id_list decaf_type T_ASSIGN constant T_SEMICOLON
     {
-        $$ = new FieldDeclAssignAST((*$2)[0], *$3, (decafAST *)$5);
+        $$ = new FieldDeclAssignAST((*$2)[0], $3, (decafAST *)$5, @2.first_line);
     }
     ;
 
@@ -241,18 +256,18 @@ id_list: T_ID T_COMMA id_list
     ;
 
 
-method_decls: 
+method_decls:
     { $$ = NULL; }
-    | method_decl method_decls
+    | method_decls method_decl
     {
         decafStmtList* slist;
-        if($2 == NULL) {
+        if($1 == NULL) {
             slist = new decafStmtList();
         }
         else {
-            slist = (decafStmtList *)$2;
+            slist = (decafStmtList *)$1;
         }
-        slist->push_front($1);
+        slist->push_back($2);
         $$ = slist;
     }
     ;
@@ -260,64 +275,58 @@ method_decls:
 method_decl: T_FUNC T_ID T_LPAREN method_parameter_list T_RPAREN method_type method_block
     {
         MethodDeclAST *method;
-        method = new MethodDeclAST(*$2, *$6, (decafStmtList *)$4, (MethodBlockAST *)$7);
+        method = new MethodDeclAST(*$2, $6, (decafStmtList *)$4, (MethodBlockAST *)$7, @2.first_line);
         $$ = method;
     }
     ;
 
 method_parameter_list: 
     { $$ = NULL; }
-    | T_ID decaf_type T_COMMA method_parameter_list
+    | method_parameters
+    { $$ = $1; }
+    | method_parameters T_COMMA
+    { $$ = $1; }
+    ;
+
+method_parameters: method_parameters T_COMMA T_ID decaf_type
     {
         decafStmtList* mplist;
-        MethodVarDefAST *mv = new MethodVarDefAST(*$1, *$2);
-        mplist = (decafStmtList *)$4;
-        mplist->push_front(mv);
+        MethodVarDefAST *mv = new MethodVarDefAST(*$3, $4, @3.first_line);
+        mplist = (decafStmtList *)$1;
+        mplist->push_back(mv);
         $$ = mplist;
     }
     | T_ID decaf_type
     {
         decafStmtList* mplist;
         mplist = new decafStmtList();
-        MethodVarDefAST *mv = new MethodVarDefAST(*$1, *$2);
-        mplist->push_front(mv);
+        MethodVarDefAST *mv = new MethodVarDefAST(*$1, $2, @1.first_line);
+        mplist->push_back(mv);
         $$ = mplist;
     }
     ;
 
-method_block: begin_block var_decls statements end_block
+method_block: T_LCB var_decls statements T_RCB
     {
         MethodBlockAST *block;
         block = new MethodBlockAST((decafStmtList *)$2, (decafStmtList *)$3);
+        block->setLocation(@1.first_line, @1.first_column);
         $$ = block;
     }
     ;
 
-begin_block: T_LCB
-            { 
-                symtbl.push_front(symbol_table()); 
-            }
-            ;
-  
-end_block: T_RCB
-            {
-              symbol_table sym_table = symtbl.front();
-              symtbl.pop_front();          
-            }
-            ;
-
 var_decls:
     { $$ = NULL; }
-    | var_decl var_decls
+    | var_decls var_decl
     {
         decafStmtList* vdlist;
-        if($2 == NULL) {
+        if($1 == NULL) {
             vdlist = new decafStmtList();
         }
         else {
-            vdlist = (decafStmtList *)$2;
+            vdlist = (decafStmtList *)$1;
         }
-        vdlist->push_front($1);
+        vdlist->push_back($2);
         $$ = vdlist;
     }
     ;
@@ -327,23 +336,25 @@ var_decl: T_VAR id_list decaf_type T_SEMICOLON
         decafStmtList* vdlist = new decafStmtList();
         MethodVarDefAST* vd;
         for(int i = 0; i < $2->size(); i++) {
-            vd = new MethodVarDefAST((*$2)[i], *$3);
+            vd = new MethodVarDefAST((*$2)[i], $3, @2.first_line);
             vdlist->push_back(vd);
         }
         $$ = vdlist;
     }
     ;
 
-statements: statement statements
+statements: statements statement
     {
         decafStmtList* slist;
-        if($2 == NULL) {
+        if($1 == NULL) {
             slist = new decafStmtList();
         }
         else {
-            slist = (decafStmtList *)$2;
+            slist = (decafStmtList *)$1;
         }
-        slist->push_front($1);
+        // the location of each statement, for decafcomp -g
+        $2->setLocation(@2.first_line, @2.first_column);
+        slist->push_back($2);
         $$ = slist;
     }
     |
@@ -388,10 +399,11 @@ continue_stmt: T_CONTINUE T_SEMICOLON
     }
     ;
 
-block: begin_block var_decls statements end_block
+block: T_LCB var_decls statements T_RCB
     {
         BlockAST *block;
         block = new BlockAST((decafStmtList *)$2, (decafStmtList *)$3);
+        block->setLocation(@1.first_line, @1.first_column);
         $$ = block;
     }
     ;
@@ -407,103 +419,103 @@ expr: value_var
     | expr T_PLUS expr
     {
         BinaryExpr *b;
-        b = new BinaryExpr(*$2, (decafAST *)$1, (decafAST *)$3);
+        b = new BinaryExpr($2, (decafAST *)$1, (decafAST *)$3);
         $$ = b;
     }
     | expr T_MINUS expr
     {
         BinaryExpr *b;
-        b = new BinaryExpr(*$2, (decafAST *)$1, (decafAST *)$3);
+        b = new BinaryExpr($2, (decafAST *)$1, (decafAST *)$3);
         $$ = b;
     }
     | expr T_MULT expr
     {
         BinaryExpr *b;
-        b = new BinaryExpr(*$2, (decafAST *)$1, (decafAST *)$3);
+        b = new BinaryExpr($2, (decafAST *)$1, (decafAST *)$3);
         $$ = b;
     }
     | expr T_DIV expr
     {
         BinaryExpr *b;
-        b = new BinaryExpr(*$2, (decafAST *)$1, (decafAST *)$3);
+        b = new BinaryExpr($2, (decafAST *)$1, (decafAST *)$3);
         $$ = b;
     }
     | expr T_LEFTSHIFT expr
     {
         BinaryExpr *b;
-        b = new BinaryExpr(*$2, (decafAST *)$1, (decafAST *)$3);
+        b = new BinaryExpr($2, (decafAST *)$1, (decafAST *)$3);
         $$ = b;
     }
     | expr T_RIGHTSHIFT expr
     {
         BinaryExpr *b;
-        b = new BinaryExpr(*$2, (decafAST *)$1, (decafAST *)$3);
+        b = new BinaryExpr($2, (decafAST *)$1, (decafAST *)$3);
         $$ = b;
     }
     | expr T_MOD expr
     {
         BinaryExpr *b;
-        b = new BinaryExpr(*$2, (decafAST *)$1, (decafAST *)$3);
+        b = new BinaryExpr($2, (decafAST *)$1, (decafAST *)$3);
         $$ = b;
     }
     | expr T_EQ expr
     {
         BinaryExpr *b;
-        b = new BinaryExpr(*$2, (decafAST *)$1, (decafAST *)$3);
+        b = new BinaryExpr($2, (decafAST *)$1, (decafAST *)$3);
         $$ = b;
     }
     | expr T_NEQ expr
     {
         BinaryExpr *b;
-        b = new BinaryExpr(*$2, (decafAST *)$1, (decafAST *)$3);
+        b = new BinaryExpr($2, (decafAST *)$1, (decafAST *)$3);
         $$ = b;
     }
     | expr T_LT expr
     {
         BinaryExpr *b;
-        b = new BinaryExpr(*$2, (decafAST *)$1, (decafAST *)$3);
+        b = new BinaryExpr($2, (decafAST *)$1, (decafAST *)$3);
         $$ = b;
     }
     | expr T_LEQ expr
     {
         BinaryExpr *b;
-        b = new BinaryExpr(*$2, (decafAST *)$1, (decafAST *)$3);
+        b = new BinaryExpr($2, (decafAST *)$1, (decafAST *)$3);
         $$ = b;
     }
     | expr T_GT expr
     {
         BinaryExpr *b;
-        b = new BinaryExpr(*$2, (decafAST *)$1, (decafAST *)$3);
+        b = new BinaryExpr($2, (decafAST *)$1, (decafAST *)$3);
         $$ = b;
     }
     | expr T_GEQ expr
     {
         BinaryExpr *b;
-        b = new BinaryExpr(*$2, (decafAST *)$1, (decafAST *)$3);
+        b = new BinaryExpr($2, (decafAST *)$1, (decafAST *)$3);
         $$ = b;
     }
     | expr T_AND expr
     {
         BinaryExpr *b;
-        b = new BinaryExpr(*$2, (decafAST *)$1, (decafAST *)$3);
+        b = new BinaryExpr($2, (decafAST *)$1, (decafAST *)$3);
         $$ = b;
     }
     | expr T_OR expr
     {
         BinaryExpr *b;
-        b = new BinaryExpr(*$2, (decafAST *)$1, (decafAST *)$3);
+        b = new BinaryExpr($2, (decafAST *)$1, (decafAST *)$3);
         $$ = b;
     }
     | T_NOT expr %prec T_MOD
     {
         UnaryExpr *u;
-        u = new UnaryExpr(*$1, (decafAST *)$2);
+        u = new UnaryExpr($1, (decafAST *)$2);
         $$ = u;
     }
     | T_MINUS expr %prec T_MOD
     {
         UnaryExpr *u;
-        u = new UnaryExpr("UnaryMinus", (decafAST *)$2);
+        u = new UnaryExpr(OP_UNARYMINUS, (decafAST *)$2);
         $$ = u;
     }
     | T_LPAREN expr T_RPAREN
@@ -556,6 +568,7 @@ method_call: T_ID T_LPAREN method_arg_list T_RPAREN
     {
         MethodCallAST *method;
         method = new MethodCallAST(*$1, (decafStmtList *)$3);
+        method->setLocation(@1.first_line, @1.first_column);
         $$ = method;
     }
     ;
@@ -570,12 +583,20 @@ method_arg: expr
     }
     ;
 
-method_arg_list: method_arg T_COMMA method_arg_list
+method_arg_list: method_args
+    { $$ = $1; }
+    | method_args T_COMMA
+    { $$ = $1; }
+    | 
+    { $$ = NULL; }
+    ;
+
+method_args: method_args T_COMMA method_arg
     {
         decafStmtList* mlist;
-        decafAST *m = (decafAST *)$1;
-        mlist = (decafStmtList *)$3;
-        mlist->push_front(m);
+        decafAST *m = (decafAST *)$3;
+        mlist = (decafStmtList *)$1;
+        mlist->push_back(m);
         $$ = mlist;
     }
     | method_arg
@@ -583,11 +604,9 @@ method_arg_list: method_arg T_COMMA method_arg_list
         decafStmtList* mlist;
         mlist = new decafStmtList();
         decafAST *m = (decafAST *)$1;
-        mlist->push_front(m);
+        mlist->push_back(m);
         $$ = mlist;
     }
-    | 
-    { $$ = NULL; }
     ;
 
 
@@ -607,12 +626,12 @@ assign: value_var T_ASSIGN expr
     }
     ;
 
-assign_list: assign T_COMMA assign_list
+assign_list: assign_list T_COMMA assign
     {
         decafStmtList* alist;
-        decafAST *a = (decafAST *)$1;
-        alist = (decafStmtList *)$3;
-        alist->push_front(a);
+        decafAST *a = (decafAST *)$3;
+        alist = (decafStmtList *)$1;
+        alist->push_back(a);
         $$ = alist;
     }
     | assign
@@ -620,7 +639,7 @@ assign_list: assign T_COMMA assign_list
         decafStmtList* alist;
         alist = new decafStmtList();
         decafAST *a = (decafAST *)$1;
-        alist->push_front(a);
+        alist->push_back(a);
         $$ = alist;
     }
     ;
@@ -628,7 +647,7 @@ assign_list: assign T_COMMA assign_list
 for_stmt: T_FOR T_LPAREN assign_list T_SEMICOLON expr T_SEMICOLON assign_list T_RPAREN block
     {
         ForAST *for_s;
-        for_s = new ForAST((decafStmtList *)$3, (decafAST *)$5, (decafStmtList *)$7, (decafAST *)$9);
+        for_s = new ForAST((decafStmtList *)$3, (decafAST *)$5, (decafStmtList *)$7, (BlockAST *)$9);
         $$ = for_s;
     }
     ;
@@ -650,7 +669,7 @@ if_stmt: T_IF T_LPAREN expr T_RPAREN block
 while_stmt: T_WHILE T_LPAREN expr T_RPAREN block
     {
         WhileAST *while_s;
-        while_s = new WhileAST((decafAST *)$3, (decafStmtList *)$5);
+        while_s = new WhileAST((decafAST *)$3, (BlockAST *)$5);
         $$ = while_s;
     }
     ;
@@ -672,7 +691,7 @@ return_stmt: T_RETURN T_SEMICOLON
     | T_RETURN T_LPAREN expr T_RPAREN T_SEMICOLON
     {
         ReturnAST *return_s;
-        return_s = new ReturnAST((decafStmtList *)$3);
+        return_s = new ReturnAST((decafAST *)$3);
         $$ = return_s;
     }
     ;
@@ -711,17 +730,158 @@ method_type: T_VOID
 
 %%
 
-int main() {
-  // initialize LLVM
-  llvm::LLVMContext &Context = TheContext;
-  // Make the module, which holds all the code.
-  TheModule = new llvm::Module("Test", Context);
-  // set up symbol table
-  symtbl.push_front(symbol_table());
-  int retval = yyparse();
-  // remove symbol table
-  symtbl.pop_front();
-  TheModule->print(llvm::errs(), nullptr);
-  return(retval >= 1 ? EXIT_FAILURE : EXIT_SUCCESS);
+
+// -O: verify the module and run the usual cleanup passes over each
+// function. A module that does not verify is left alone, the passes
+// assume well formed IR.
+static void optimize_module(decaf_compiler &c) {
+  decaf_mem_category llvm(MEM_LLVM);
+  {
+    decaf_phase phase(c.timer, "verify");
+    if (llvm::verifyModule(*c.TheModule)) {
+      return;
+    }
+  }
+  decaf_phase phase(c.timer, "optimize");
+  llvm::legacy::FunctionPassManager passes(c.TheModule);
+  passes.add(llvm::createPromoteMemoryToRegisterPass());
+  passes.add(llvm::createInstructionCombiningPass());
+  passes.add(llvm::createReassociatePass());
+  passes.add(llvm::createGVNPass());
+  passes.add(llvm::createCFGSimplificationPass());
+  passes.doInitialization();
+  for (llvm::Function &F : *c.TheModule) {
+    if (!F.isDeclaration()) {
+      passes.run(F);
+    }
+  }
+  passes.doFinalization();
 }
 
+int decaf_compiler::compile(const char *path) {
+  {
+    decaf_mem_category llvm(MEM_LLVM);
+    // Make the module, which holds all the code.
+    TheModule = new llvm::Module("Test", TheContext);
+  }
+  yyscan_t scanner = decaf_scan_begin(*this, path);
+  if (scanner == NULL) {
+    return -1;
+  }
+  int retval;
+  {
+    decaf_phase phase(timer, "parse");
+    decaf_mem_category ast(MEM_AST);
+    retval = yyparse(scanner, *this);
+  }
+  decaf_scan_end(scanner);
+  debug.begin(TheModule, path, optimizeIR);
+  if (parsedProgram != NULL) {
+    try {
+      {
+        decaf_phase phase(timer, "resolve");
+        decaf_mem_category ast(MEM_AST);
+        // the outermost scope holds the externs and the fields
+        symtbl.enter_scope();
+        parsedProgram->Resolve(*this);
+        symtbl.exit_scope();
+      }
+      decaf_phase phase(timer, "codegen");
+      decaf_mem_category llvm(MEM_LLVM);
+      parsedProgram->Codegen(*this);
+    }
+    catch (std::runtime_error &e) {
+      out << "semantic error: " << e.what() << endl;
+      return DECAF_SEMANTIC_ERROR;
+    }
+  }
+  debug.finish();
+  if (optimizeIR) {
+    optimize_module(*this);
+  }
+  return retval >= 1 ? DECAF_SYNTAX_ERROR : 0;
+}
+
+decaf_compiler::~decaf_compiler() {
+  decaf_mem_category ast(MEM_AST);
+  delete parsedProgram;
+  decaf_mem_category llvm(MEM_LLVM);
+  debug.finish();
+  delete TheModule;
+}
+
+#ifndef DECAF_NO_MAIN
+// -t, -T and -m: the reports go to stdout, stderr has the module
+static void report_phases(decaf_compiler &compiler, bool summary, const char *trace_path) {
+  if (summary) {
+    compiler.timer.summary(cout);
+  }
+  if (memoryStats.enabled) {
+    memoryStats.report(cout);
+  }
+  if (trace_path != NULL) {
+    ofstream trace(trace_path);
+    compiler.timer.trace(trace);
+    if (!trace) {
+      perror(trace_path);
+    }
+  }
+}
+
+int main(int argc, char **argv) {
+  // decafcomp [-i] [-s] [-O] [-g] [-p] [-t] [-T trace.json] [-m] [file]
+  //   -i  also print the AST, indented
+  //   -s  scan with the hand-written scanner in decaf-scan.h
+  //   -O  optimize the module before printing it
+  //   -g  emit DWARF debug info, see decaf-debug.h
+  //   -p  count the calls and cycles of each method when the program runs, see decaf-profile.h
+  //   -t  print how long each phase took
+  //   -T  write the phases as a Chrome trace_event file
+  //   -m  print the heap allocations of each phase and kind of object,
+  //       in a build with -DDECAF_MEMORY_ACCOUNTING
+  decaf_compiler compiler;
+  bool summary = false;
+  const char *trace_path = NULL;
+  int arg = 1;
+  for (; arg < argc && argv[arg][0] == '-' && argv[arg][1] != '\0'; arg++) {
+    if (strcmp(argv[arg], "-i") == 0) {
+      compiler.printAST = compiler.indentAST = true;
+    } else if (strcmp(argv[arg], "-s") == 0) {
+      compiler.handScanner = true;
+    } else if (strcmp(argv[arg], "-O") == 0) {
+      compiler.optimizeIR = true;
+    } else if (strcmp(argv[arg], "-g") == 0) {
+      compiler.debug.enabled = true;
+    } else if (strcmp(argv[arg], "-p") == 0) {
+      compiler.profile.enabled = true;
+    } else if (strcmp(argv[arg], "-t") == 0) {
+      summary = true;
+    } else if (strcmp(argv[arg], "-T") == 0 && arg + 1 < argc) {
+      trace_path = argv[++arg];
+    } else if (strcmp(argv[arg], "-m") == 0) {
+#ifdef DECAF_MEMORY_ACCOUNTING
+      memoryStats.enabled = true;
+#else
+      cerr << "decafcomp: -m needs a build with -DDECAF_MEMORY_ACCOUNTING" << endl;
+      return EXIT_FAILURE;
+#endif
+    } else {
+      cerr << "usage: decafcomp [-i] [-s] [-O] [-g] [-p] [-t] [-T trace.json] [-m] [file]" << endl;
+      return EXIT_FAILURE;
+    }
+  }
+  compiler.timer.enabled = summary || trace_path != NULL;
+  int status = compiler.compile(arg < argc ? argv[arg] : NULL);
+  if (status == -1 || status == DECAF_SEMANTIC_ERROR) {
+    report_phases(compiler, summary, trace_path);
+    return EXIT_FAILURE;
+  }
+  {
+    decaf_phase phase(compiler.timer, "emit");
+    decaf_mem_category llvm(MEM_LLVM);
+    compiler.module()->print(llvm::errs(), nullptr);
+  }
+  report_phases(compiler, summary, trace_path);
+  return (status != 0 ? EXIT_FAILURE : EXIT_SUCCESS);
+}
+#endif
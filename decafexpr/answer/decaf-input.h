@@ -0,0 +1,111 @@
+
+#ifndef _DECAF_INPUT
+#define _DECAF_INPUT
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// The whole source program is kept in one buffer and scanned in place
+// with yy_scan_buffer(), so flex never copies input bytes into its own
+// buffers. flex needs the buffer to end with two NUL bytes
+// (YY_END_OF_BUFFER_CHAR) right after the last input byte.
+
+typedef struct decaf_input {
+  char *base;    // first input byte
+  size_t len;    // number of input bytes, not counting the two NULs
+  size_t maplen; // length of the mapping, 0 if base was malloc'd
+} decaf_input;
+
+// map a regular file: reserve zeroed anonymous pages for len + 2 bytes
+// and map the file over the front of them. The tail of the last file
+// page is zero filled by the kernel, and if the file ends on a page
+// boundary the two NULs come from the anonymous page after it.
+// The mapping is private and writable because flex temporarily writes
+// a NUL after each token.
+static bool decaf_map_file(int fd, size_t len, decaf_input *in)
+{
+  size_t maplen = len + 2;
+  void *base = mmap(NULL, maplen, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (base == MAP_FAILED) {
+    return false;
+  }
+  if (len > 0) {
+    if (mmap(base, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+      munmap(base, maplen);
+      return false;
+    }
+    madvise(base, len, MADV_SEQUENTIAL);
+  }
+  in->base = (char *)base;
+  in->len = len;
+  in->maplen = maplen;
+  return true;
+}
+
+// read a pipe or terminal once into a single growing buffer
+static bool decaf_slurp(int fd, decaf_input *in)
+{
+  size_t cap = 1 << 16;
+  size_t len = 0;
+  char *buf = (char *)malloc(cap);
+  if (buf == NULL) {
+    return false;
+  }
+  for (;;) {
+    if (cap - len <= 2) {
+      char *grown = (char *)realloc(buf, cap * 2);
+      if (grown == NULL) {
+        free(buf);
+        return false;
+      }
+      buf = grown;
+      cap *= 2;
+    }
+    ssize_t n = read(fd, buf + len, cap - len - 2);
+    if (n == 0) {
+      break;
+    }
+    if (n < 0) {
+      free(buf);
+      return false;
+    }
+    len += n;
+  }
+  buf[len] = buf[len + 1] = '\0';
+  in->base = buf;
+  in->len = len;
+  in->maplen = 0;
+  return true;
+}
+
+// mmap regular files read from offset 0, slurp everything else
+static bool decaf_read_input(int fd, decaf_input *in)
+{
+  struct stat st;
+  if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && lseek(fd, 0, SEEK_CUR) == 0) {
+    if (decaf_map_file(fd, st.st_size, in)) {
+      return true;
+    }
+  }
+  return decaf_slurp(fd, in);
+}
+
+static void decaf_release_input(decaf_input *in)
+{
+  if (in->base == NULL) {
+    return;
+  }
+  if (in->maplen > 0) {
+    munmap(in->base, in->maplen);
+  } else {
+    free(in->base);
+  }
+  in->base = NULL;
+}
+
+#endif
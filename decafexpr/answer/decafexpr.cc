@@ -1,5 +1,6 @@
 
 #include "default-defs.h"
+#include "decaf-print.h"
 #include <algorithm>
 #include <list>
 #include <ostream>
@@ -104,38 +105,48 @@ descriptor* access_symtbl(string id)
 class decafAST {
 public:
   virtual ~decafAST() {}
-  virtual string str() { return string(""); }
+  // print - write the node as an ASDL term straight to out
+  virtual void print(ostream &out) = 0;
   virtual llvm::Value *Codegen() = 0;
 };
 
-string getString(decafAST *d) {
+void printNode(ostream &out, decafAST *d) {
 	if (d != NULL) {
-		return d->str();
+		d->print(out);
 	} else {
-		return string("None");
+		out << "None";
 	}
 }
 
+// flat text of a small subtree, e.g. the constant of a field declaration
+string getString(decafAST *d) {
+	ostringstream s;
+	printNode(s, d);
+	return s.str();
+}
+
 class decafStr : public decafAST {
 	string Input;
 public:
 	decafStr(string input) : Input(input) {}
-	string str() { return string(Input); }
+	void print(ostream &out) { out << Input; }
 	llvm::Value *Codegen() { 
 
 	}
 };
 
 template <class T>
-string commaList(list<T> vec) {
-    string s("");
+void printList(ostream &out, list<T> &vec) {
+    if (vec.empty()) {
+        out << "None";
+        return;
+    }
     for (typename list<T>::iterator i = vec.begin(); i != vec.end(); i++) { 
-        s = s + (s.empty() ? string("") : string(",")) + (*i)->str(); 
-    }   
-    if (s.empty()) {
-        s = string("None");
+        if (i != vec.begin()) {
+            out << ',';
+        }
+        (*i)->print(out);
     }   
-    return s;
 }
 
 template <class T>
@@ -165,7 +176,7 @@ public:
 	int size() { return stmts.size(); }
 	void push_front(decafAST *e) { stmts.push_front(e); }
 	void push_back(decafAST *e) { stmts.push_back(e); }
-	string str() { return commaList<class decafAST *>(stmts); }
+	void print(ostream &out) { printList<class decafAST *>(out, stmts); }
 	llvm::Value *Codegen() { 
 		return listCodegen<decafAST *>(stmts); 
 	}
@@ -182,8 +193,12 @@ public:
 		if (FieldDeclList != NULL) { delete FieldDeclList; }
 		if (MethodDeclList != NULL) { delete MethodDeclList; }
 	}
-	string str() { 
-		return string("Package") + "(" + Name + "," + getString(FieldDeclList) + "," + getString(MethodDeclList) + ")";
+	void print(ostream &out) {
+		out << "Package(" << Name << ',';
+		printNode(out, FieldDeclList);
+		out << ',';
+		printNode(out, MethodDeclList);
+		out << ')';
 	}
 	llvm::Value *Codegen() { 
 		llvm::Value *val = NULL;
@@ -209,7 +224,13 @@ public:
 		if (ExternList != NULL) { delete ExternList; } 
 		if (PackageDef != NULL) { delete PackageDef; }
 	}
-	string str() { return string("Program") + "(" + getString(ExternList) + "," + getString(PackageDef) + ")"; }
+	void print(ostream &out) {
+		out << "Program(";
+		printNode(out, ExternList);
+		out << ',';
+		printNode(out, PackageDef);
+		out << ')';
+	}
 	llvm::Value *Codegen() { 
 		llvm::Value *val = NULL;
 		if (NULL != ExternList) {
@@ -228,8 +249,8 @@ class ExternVarDefAST : public decafAST {
 	string Type;
 public:
 	ExternVarDefAST(string type) : Type(type) {}
-	string str() {
-		return string("VarDef") + "(" + Type + ")";
+	void print(ostream &out) {
+		out << "VarDef(" << Type << ')';
 	}
 	string getVarType() {
 		return Type;
@@ -245,8 +266,10 @@ class ExternFunctionAST : public decafAST {
 	decafStmtList *ParameterTypeList;
 public:
 	ExternFunctionAST(string name, string type, decafStmtList *types) : Name(name), ReturnType(type), ParameterTypeList(types) {}
-	string str() {
-		return string("ExternFunction") + "(" + Name + "," + ReturnType + "," + getString(ParameterTypeList) + ")";
+	void print(ostream &out) {
+		out << "ExternFunction(" << Name << ',' << ReturnType << ',';
+		printNode(out, ParameterTypeList);
+		out << ')';
 	}
 	llvm::Value *Codegen(){
 		llvm::Type *returnTy = getLLVMType(ReturnType);
@@ -277,13 +300,8 @@ class FieldDeclAST : public decafAST {
 	bool isAssignmnet;
 public:
 	FieldDeclAST(string name, string type, string extra, bool assignment) : Name(name), Type(type), Extra(extra), isAssignmnet(assignment) {}
-	string str() {
-		if (isAssignmnet) {
-			return string("AssignGlobalVar") + "(" + Name + "," + Type + "," + Extra + ")";
-		}
-		else {
-			return string("FieldDecl") + "(" + Name + "," + Type + "," + Extra + ")";
-		}
+	void print(ostream &out) {
+		out << (isAssignmnet ? "AssignGlobalVar(" : "FieldDecl(") << Name << ',' << Type << ',' << Extra << ')';
 	}
 	llvm::Value *Codegen(){
 		return NULL;
@@ -295,13 +313,8 @@ class ConstantAST : public decafAST {
 	bool isNum;
 public:
 	ConstantAST(string value, bool is) : Value(value), isNum(is) {}
-	string str() {
-		if(isNum) {
-			return string("NumberExpr") + "(" + Value + ")";
-		}
-		else {
-			return string("BoolExpr") + "(" + Value + ")";
-		}
+	void print(ostream &out) {
+		out << (isNum ? "NumberExpr(" : "BoolExpr(") << Value << ')';
 	}
 	llvm::Value *Codegen(){
 		llvm::Value *val;
@@ -323,8 +336,12 @@ class BlockAST : public decafAST {
 	decafStmtList *StmtList;
 public:
 	BlockAST(decafStmtList *vdL, decafStmtList *stL) : VarDecList(vdL), StmtList(stL) {}
-	string str() {
-		return string("Block") + "(" + getString(VarDecList) + "," + getString(StmtList) + ")";
+	void print(ostream &out) {
+		out << "Block(";
+		printNode(out, VarDecList);
+		out << ',';
+		printNode(out, StmtList);
+		out << ')';
 	}
 	llvm::Value *Codegen(){
 		return NULL;
@@ -338,8 +355,12 @@ class MethodBlockAST : public decafAST {
 	decafStmtList *StmtList;
 public:
 	MethodBlockAST(decafStmtList *vdL, decafStmtList *stL) : VarDecList(vdL), StmtList(stL) {}
-	string str() {
-			return string("MethodBlock") + "(" + getString(VarDecList) + "," + getString(StmtList) + ")";
+	void print(ostream &out) {
+		out << "MethodBlock(";
+		printNode(out, VarDecList);
+		out << ',';
+		printNode(out, StmtList);
+		out << ')';
 	}
 	llvm::Value *Codegen(){
     symtbl.push_front(symbol_table());
@@ -357,8 +378,8 @@ class MethodVarDefAST : public decafAST {
 	string Type;
 public:
 	MethodVarDefAST(string name, string type) : Name(name), Type(type) {}
-	string str() {
-		return string("VarDef") + "(" + Name + "," + Type + ")";
+	void print(ostream &out) {
+		out << "VarDef(" << Name << ',' << Type << ')';
 	}
 	string getVarType() {
 		return Type;
@@ -389,8 +410,12 @@ class MethodDeclAST : public decafAST {
 	MethodBlockAST *MethodBlock;
 public:
 	MethodDeclAST(string name, string type, decafStmtList *params, MethodBlockAST *block) : Name(name), ReturnType(type), ParameterList(params), MethodBlock(block) {}
-	string str() {
-		return string("Method") + "(" + Name + "," + ReturnType + "," + getString(ParameterList) + "," + getString(MethodBlock) + ")";
+	void print(ostream &out) {
+		out << "Method(" << Name << ',' << ReturnType << ',';
+		printNode(out, ParameterList);
+		out << ',';
+		printNode(out, MethodBlock);
+		out << ')';
 	}
 	llvm::Value *Codegen(){
 		//descriptor* d = access_symtbl(Name);
@@ -457,8 +482,10 @@ public:
 	~MethodCallAST() {
 		if(ArgList != NULL) { delete ArgList; }
 	}
-	string str() {
-		return string("MethodCall") + "(" + Name + "," + getString(ArgList) +")"; 
+	void print(ostream &out) {
+		out << "MethodCall(" << Name << ',';
+		printNode(out, ArgList);
+		out << ')';
 	}
 	llvm::Value *Codegen() {
         llvm::Function *call = TheModule->getFunction(Name);			
@@ -503,15 +530,17 @@ public:
   decafStmtList* getIndexExpr() { return IndexExpr; }
   bool isArray() { return ArrayFlag; }	
 	   
-  string str()
+  void print(ostream &out)
   {
     if(ArrayFlag == false)
     {
-      return string("VariableExpr") + "(" + Name + ")";
+      out << "VariableExpr(" << Name << ')';
     } 
     else
     { 
-      return string("ArrayLocExpr") + "(" + Name + "," + getString(IndexExpr) +")";
+      out << "ArrayLocExpr(" << Name << ',';
+      printNode(out, IndexExpr);
+      out << ')';
     }  
   }
   llvm::Value *Codegen() 
@@ -529,19 +558,20 @@ class AssignAST : public decafAST
 	decafAST* Expr;
 public: 
 	AssignAST(ValueAST* value, decafAST* expr) : Value(value), Expr(expr) {}
-	string str()
+	void print(ostream &out)
 	{
-		string Name;
 		if(!(Value->isArray()))
 		{
-		Name = string("AssignVar");
-		return Name + "(" + Value->getID() + "," + getString(Expr) + ")";
+		out << "AssignVar(" << Value->getID() << ',';
 		}
 		else
 		{
-		Name = string("AssignArrayLoc");
-		return Name + "(" + Value->getID() + "," + getString(Value->getIndexExpr()) + ","+ getString(Expr) + ")";
+		out << "AssignArrayLoc(" << Value->getID() << ',';
+		printNode(out, Value->getIndexExpr());
+		out << ',';
 		} 
+		printNode(out, Expr);
+		out << ')';
 	}
 	llvm::Value *Codegen() {
 		llvm::Value *val;
@@ -568,8 +598,14 @@ class IfAST : public decafAST {
 	decafStmtList *Else_Block;
 public:
 	IfAST(decafAST *cond, decafStmtList *ifblock, decafStmtList *elseblock) : Condition(cond), If_Block(ifblock), Else_Block(elseblock) {}
-	string str() {
-		return string("IfStmt") + "(" + getString(Condition) + "," + getString(If_Block) + "," + getString(Else_Block) + ")";
+	void print(ostream &out) {
+		out << "IfStmt(";
+		printNode(out, Condition);
+		out << ',';
+		printNode(out, If_Block);
+		out << ',';
+		printNode(out, Else_Block);
+		out << ')';
 	}
 	llvm::Value *Codegen(){
 		return NULL;
@@ -581,8 +617,12 @@ class WhileAST : public decafAST {
 	decafStmtList *Block;
 public:
 	WhileAST(decafAST *cond, decafStmtList *block) : Condition(cond), Block(block) {}
-	string str() {
-		return string("WhileStmt") + "(" + getString(Condition) + "," + getString(Block) + ")";
+	void print(ostream &out) {
+		out << "WhileStmt(";
+		printNode(out, Condition);
+		out << ',';
+		printNode(out, Block);
+		out << ')';
 	}
 	llvm::Value *Codegen(){
 		return NULL;
@@ -596,8 +636,16 @@ class ForAST : public decafAST {
 	decafAST *Block;
 public:
 	ForAST(decafStmtList *pre, decafAST *cond, decafStmtList *loop, decafAST *b) : PreAssignList(pre), Condition(cond), LoopAssignList(loop), Block(b) {}
-	string str() {
-		return string("ForStmt") + "(" + getString(PreAssignList) + "," + getString(Condition) + "," + getString(LoopAssignList) + "," + getString(Block) + ")";
+	void print(ostream &out) {
+		out << "ForStmt(";
+		printNode(out, PreAssignList);
+		out << ',';
+		printNode(out, Condition);
+		out << ',';
+		printNode(out, LoopAssignList);
+		out << ',';
+		printNode(out, Block);
+		out << ')';
 	}
 	llvm::Value *Codegen(){
 		return NULL;
@@ -608,8 +656,10 @@ class ReturnAST : public decafAST {
 	decafStmtList *Expr;
 public:
 	ReturnAST(decafStmtList *expr) : Expr(expr) {}
-	string str() {
-		return string("ReturnStmt") + "(" + getString(Expr) + ")";
+	void print(ostream &out) {
+		out << "ReturnStmt(";
+		printNode(out, Expr);
+		out << ')';
 	}
 	llvm::Value *Codegen(){
 		llvm::Value* val;
@@ -630,8 +680,12 @@ class BinaryExpr : public decafAST {
 	decafAST *RightValue;
 public:
 	BinaryExpr(string op, decafAST *l, decafAST *r) : BinaryOperator(op), LeftValue(l), RightValue(r) {}
-	string str() {
-		return string("BinaryExpr") + "(" + BinaryOperator + "," + getString(LeftValue) + "," + getString(RightValue) + ")";
+	void print(ostream &out) {
+		out << "BinaryExpr(" << BinaryOperator << ',';
+		printNode(out, LeftValue);
+		out << ',';
+		printNode(out, RightValue);
+		out << ')';
 	}
 	llvm::Value *Codegen(){
 		llvm::Value* val;
@@ -661,8 +715,10 @@ class UnaryExpr : public decafAST {
 	decafAST *Expr;
 public:
 	UnaryExpr(string op, decafAST *e) : UnaryOperator(op), Expr(e){}
-	string str() {
-		return string("UnaryExpr") + "(" + UnaryOperator + "," + getString(Expr) + ")";
+	void print(ostream &out) {
+		out << "UnaryExpr(" << UnaryOperator << ',';
+		printNode(out, Expr);
+		out << ')';
 	}
 	llvm::Value *Codegen(){
 		llvm::Value* val;
@@ -729,8 +785,8 @@ class StringConstantAST : public decafAST {
 	string value;
 public:
 	StringConstantAST(string v) : value(v) {}
-	string str() {
-		return string("StringConstant") + "(" + value + ")";
+	void print(ostream &out) {
+		out << "StringConstant(" << value << ')';
 	}
 	llvm::Value *Codegen(){
 		llvm::GlobalVariable *GS = Builder.CreateGlobalString(removeChar(value.substr(1, value.size() - 2), '\\'), "globalstring");
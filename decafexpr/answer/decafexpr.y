@@ -5,11 +5,10 @@
 #include <cstdlib>
 #include "default-defs.h"
 
-int yylex(void);
-int yyerror(char *); 
-
 // print AST?
 bool printAST = false;
+// print the AST indented instead of on one line (-i)
+bool indentAST = false;
 
 using namespace std;
 
@@ -57,6 +56,18 @@ llvm::Function *gen_print_int_def() {
 
 %}
 
+// a pure parser with a reentrant scanner: the scanner keeps its state
+// in the yyscan_t, though the code is still generated into the globals
+// above, so only one file is compiled at a time
+%define api.pure full
+%locations
+%param {yyscan_t scanner}
+
+%code provides {
+int yylex(YYSTYPE *lval, YYLTYPE *lloc, yyscan_t scanner);
+int yyerror(YYLTYPE *loc, yyscan_t scanner, const char *s);
+}
+
 %union{
     class decafAST *ast;
     std::string *sval;
@@ -137,14 +148,22 @@ program: extern_list decafpackage
     { 
         ProgramAST *prog = new ProgramAST((decafStmtList *)$1, (PackageAST *)$2); 
 		if (printAST) {
-			cout << getString(prog) << endl;
+			if (indentAST) {
+				decaf_indent_buf indented(cout.rdbuf());
+				ostream out(&indented);
+				prog->print(out);
+				out << '\n';
+			} else {
+				prog->print(cout);
+				cout << '\n';
+			}
+			cout.flush();
 		}
         try {
             prog->Codegen();
         } 
         catch (std::runtime_error &e) {
             cout << "semantic error: " << e.what() << endl;
-            //cout << prog->str() << endl; 
             exit(EXIT_FAILURE);
         }
         delete prog;
@@ -774,7 +793,22 @@ ignore: ignore T_ID
 
 %%
 
-int main() {
+int main(int argc, char **argv) {
+  // decafexpr [-i] [file]: -i also prints the AST, indented
+  int arg = 1;
+  for (; arg < argc && argv[arg][0] == '-' && argv[arg][1] != '\0'; arg++) {
+    if (strcmp(argv[arg], "-i") == 0) {
+      printAST = indentAST = true;
+    } else {
+      cerr << "usage: decafexpr [-i] [file]" << endl;
+      return EXIT_FAILURE;
+    }
+  }
+  // map the source file (or stdin) so the lexer scans it in place
+  yyscan_t scanner = decaf_scan_begin(arg < argc ? argv[arg] : NULL);
+  if (scanner == NULL) {
+    return EXIT_FAILURE;
+  }
   // initialize LLVM
   llvm::LLVMContext &Context = TheContext;
   // Make the module, which holds all the code.
@@ -784,7 +818,8 @@ int main() {
   // set up dummy main function
   //TheFunction = gen_main_def();
   // parse the input and create the abstract syntax tree
-  int retval = yyparse();
+  int retval = yyparse(scanner);
+  decaf_scan_end(scanner);
   // remove symbol table
   symtbl.pop_front();
   // Finish off the main function. (see the WARNING above)
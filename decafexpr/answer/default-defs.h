@@ -15,18 +15,18 @@
 #include <stdexcept>
 #include <vector>
 
-extern int lineno;
-extern int tokenpos;
-
 using namespace std;
 
-extern "C"
-{
-	extern int yyerror(const char *);
-	int yyparse(void);
-	int yylex(void);  
-	int yywrap(void);
-}
+// the reentrant flex scanner of decafexpr.lex
+#ifndef YY_TYPEDEF_YY_SCANNER_T
+#define YY_TYPEDEF_YY_SCANNER_T
+typedef void *yyscan_t;
+#endif
+
+// defined in the lexer: a scanner for the whole file (stdin if NULL),
+// scanned in place. NULL if the file cannot be read.
+extern yyscan_t decaf_scan_begin(const char *path);
+extern void decaf_scan_end(yyscan_t scanner);
 
 typedef struct array {
     std::string* size;
@@ -47,10 +47,6 @@ typedef map<string, descriptor*> symbol_table;
 
 typedef list<symbol_table> symbol_table_list;
 
-extern int lineno;
-
-extern int tokenpos;
-
 extern symbol_table_list symtbl;
 
 extern descriptor* access_symtbl(string id);
@@ -6,7 +6,7 @@
 #include "default-defs.h"
 
 int yylex(void);
-int yyerror(char *); 
+int yyerror(const char *);
 
 // print AST?
 bool printAST = false;
@@ -0,0 +1,87 @@
+
+#ifndef _DECAF_OUTPUT
+#define _DECAF_OUTPUT
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <stdint.h>
+#include <unistd.h>
+
+// decaf_writer - collects output in one large buffer and hands it to
+// write(2) only when the buffer fills up or on flush(), instead of once
+// per token. exit() does not run the destructor, so flush() before it.
+class decaf_writer {
+  int fd;
+  char *buf;
+  size_t len;
+  size_t cap;
+
+  void write_all(const char *p, size_t n) {
+    while (n > 0) {
+      ssize_t w = write(fd, p, n);
+      if (w < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        return;
+      }
+      p += w;
+      n -= w;
+    }
+  }
+  void drain() {
+    write_all(buf, len);
+    len = 0;
+  }
+
+public:
+  decaf_writer(int f, size_t size = 1 << 20) : fd(f), buf((char *)malloc(size)), len(0), cap(size) {}
+  ~decaf_writer() { flush(); free(buf); }
+
+  void put(const char *s, size_t n) {
+    if (len + n > cap) {
+      drain();
+      if (n > cap) {
+        write_all(s, n);
+        return;
+      }
+    }
+    memcpy(buf + len, s, n);
+    len += n;
+  }
+  void put(const char *s) { put(s, strlen(s)); }
+  void put(char c) {
+    if (len == cap) {
+      drain();
+    }
+    buf[len++] = c;
+  }
+  void flush() { drain(); }
+};
+
+// Binary token stream written by decaflex -b. The file is a header and
+// then one fixed size record per token, in input order, so a tool can
+// mmap it and index tokens directly; the token count is
+// (file size - sizeof(decaf_token_header)) / sizeof(decaf_token).
+// Offsets are byte offsets into the source file, kind is the token
+// number the lexer returns (see token_names in decaflex.lex).
+const uint32_t DECAF_TOKEN_MAGIC = 0x4b4f5444;   // "DTOK"
+const uint32_t DECAF_TOKEN_VERSION = 1;
+
+typedef struct decaf_token_header {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t record_size;   // sizeof(decaf_token)
+  uint32_t byte_order;    // 0x01020304 in the writer's byte order
+} decaf_token_header;
+
+typedef struct decaf_token {
+  uint32_t kind;
+  uint32_t offset;
+  uint32_t length;
+  uint32_t line;
+  uint32_t col;
+} decaf_token;
+
+#endif
@@ -0,0 +1,25 @@
+# Runs answer/decaflex with the flex scanner, with the hand-written
+# scanner (-s) and with the parallel scanner (-j 4) on every testcase,
+# in text and binary (-b) mode, and prints the name of each testcase
+# where the output, the error messages or the exit status differ.
+BIN=answer/decaflex
+TMP=$(mktemp -d)
+trap 'rm -rf $TMP' EXIT
+FAIL=0
+for filename in testcases/*/*.decaf; do
+	for mode in "" "-b"; do
+		$BIN $mode $filename > $TMP/flex.out 2> $TMP/flex.err
+		echo $? >> $TMP/flex.err
+		for scanner in "-s" "-j 4"; do
+			$BIN $mode $scanner $filename > $TMP/hand.out 2> $TMP/hand.err
+			echo $? >> $TMP/hand.err
+			if ! cmp -s $TMP/flex.out $TMP/hand.out || ! cmp -s $TMP/flex.err $TMP/hand.err
+			then
+				echo "$filename $mode $scanner"
+				diff $TMP/flex.err $TMP/hand.err >&2
+				FAIL=1
+			fi
+		done
+	done
+done
+exit $FAIL
@@ -1,20 +1,359 @@
-#include <iostream>
-#include <string>
+#include <cerrno>
+#include <climits>
+#include <cstdio>
 #include <cstdlib>
+#include <cstring>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
-int main() {
-    int c = 0;
-    for (std::string line; std::getline(std::cin, line);) {
-        for (int i = 0; i < line.length(); i++) {
-            if ((line[i] == ' ') || (line[i] == '\t')){
-            	c++;
+// Removes the leading spaces and tabs of every line on stdin. A last
+// line without a newline gets one, like getline and endl would.
+//
+// Lines are never copied: each stripped line is a range of the input
+// and the ranges are handed to writev(2) in batches. A line with no
+// prefix continues the range of the line before it, so unindented text
+// goes out as one large range.
+//
+//   rmprefix [-j threads]
+//
+// With -j the input is cut into blocks at newlines and the blocks are
+// stripped on that many worker threads (0 for one per core) while one
+// thread reads ahead and another writes the finished blocks in order.
+
+// ranges_writer - collects output ranges and writes them with writev,
+// as soon as there are IOV_MAX of them unless batch is false
+class ranges_writer {
+    int fd;
+    bool batch;
+    std::vector<struct iovec> iov;
+
+public:
+    ranges_writer(int f, bool b = true) : fd(f), batch(b) {
+        if (batch) {
+            iov.reserve(IOV_MAX);
+        }
+    }
+
+    void put(const char *p, size_t n) {
+        if (n == 0) {
+            return;
+        }
+        if (!iov.empty()) {
+            struct iovec &last = iov.back();
+            if ((const char *)last.iov_base + last.iov_len == p) {
+                last.iov_len += n;
+                return;
+            }
+            if (batch && iov.size() == IOV_MAX) {
+                flush();
+            }
+        }
+        struct iovec v = { (void *)p, n };
+        iov.push_back(v);
+    }
+
+    // write out every range; the input they point into may be reused after
+    void flush() {
+        struct iovec *v = iov.data();
+        size_t n = iov.size();
+        while (n > 0) {
+            ssize_t w = writev(fd, v, n < IOV_MAX ? n : IOV_MAX);
+            if (w < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                break;
+            }
+            while (n > 0 && (size_t)w >= v->iov_len) {
+                w -= v->iov_len;
+                v++;
+                n--;
+            }
+            if (n > 0) {
+                v->iov_base = (char *)v->iov_base + w;
+                v->iov_len -= w;
+            }
+        }
+        iov.clear();
+    }
+};
+
+static const char newline = '\n';
+
+// number of spaces and tabs at p, sixteen bytes at a time
+static size_t prefix_length(const char *p, const char *end) {
+    const char *s = p;
+#ifdef __SSE2__
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i tab = _mm_set1_epi8('\t');
+    while (end - s >= 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)s);
+        unsigned mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, space), _mm_cmpeq_epi8(v, tab)));
+        if (mask != 0xffff) {
+            return s - p + __builtin_ctz(~mask);
+        }
+        s += 16;
+    }
+#endif
+    while (s < end && (*s == ' ' || *s == '\t')) {
+        s++;
+    }
+    return s - p;
+}
+
+// strip the complete lines in [p, end) and return where the first
+// incomplete one starts; at eof that one is stripped too
+static const char *strip_lines(const char *p, const char *end, bool eof, ranges_writer &out) {
+    while (p < end) {
+        const char *s = p + prefix_length(p, end);
+        const char *nl = (const char *)memchr(s, '\n', end - s);
+        if (nl == NULL) {
+            if (!eof) {
+                return p;
+            }
+            out.put(s, end - s);
+            out.put(&newline, 1);
+            return end;
+        }
+        out.put(s, nl + 1 - s);
+        p = nl + 1;
+    }
+    return p;
+}
+
+// Parallel mode. Blocks go round a ring of slots, which bounds the
+// memory in use to the ring whatever the size of the input: the reader
+// waits for the writer to free the slot it needs next.
+enum block_state { BLOCK_FREE, BLOCK_READ, BLOCK_STRIPPING, BLOCK_STRIPPED };
+
+const size_t block_size = 4 << 20;
+
+typedef struct block {
+    std::vector<char> data;     // the input, unless it is mapped
+    const char *begin;          // whole lines, unless eof
+    const char *end;
+    bool eof;
+    ranges_writer out;
+    block_state state;
+
+    block() : out(STDOUT_FILENO, false), state(BLOCK_FREE) {}
+} block;
+
+class strip_pipeline {
+    std::vector<block> slots;
+    std::mutex lock;
+    std::condition_variable changed;
+    size_t nread;       // blocks handed to the workers
+    bool done;          // the reader has handed over the last block
+
+    void strip_blocks() {
+        std::unique_lock<std::mutex> l(lock);
+        for (;;) {
+            block *b = NULL;
+            for (size_t i = 0; i < slots.size() && b == NULL; i++) {
+                if (slots[i].state == BLOCK_READ) {
+                    b = &slots[i];
+                }
             }
-            else {
+            if (b == NULL) {
+                if (done) {
+                    return;
+                }
+                changed.wait(l);
+                continue;
+            }
+            b->state = BLOCK_STRIPPING;
+            l.unlock();
+            strip_lines(b->begin, b->end, b->eof, b->out);
+            l.lock();
+            b->state = BLOCK_STRIPPED;
+            changed.notify_all();
+        }
+    }
+
+    void write_blocks() {
+        for (size_t n = 0;; n++) {
+            block &b = slots[n % slots.size()];
+            {
+                std::unique_lock<std::mutex> l(lock);
+                while (!(n < nread && b.state == BLOCK_STRIPPED) && !(done && n == nread)) {
+                    changed.wait(l);
+                }
+                if (n == nread) {
+                    return;
+                }
+            }
+            b.out.flush();
+            std::lock_guard<std::mutex> l(lock);
+            b.state = BLOCK_FREE;
+            changed.notify_all();
+        }
+    }
+
+public:
+    std::vector<std::thread> threads;
+
+    strip_pipeline(int nworkers) : slots(2 * nworkers), nread(0), done(false) {
+        for (int i = 0; i < nworkers; i++) {
+            threads.push_back(std::thread(&strip_pipeline::strip_blocks, this));
+        }
+        threads.push_back(std::thread(&strip_pipeline::write_blocks, this));
+    }
+
+    // the slot for the next block, once the writer is done with it
+    block &next() {
+        block &b = slots[nread % slots.size()];
+        std::unique_lock<std::mutex> l(lock);
+        while (b.state != BLOCK_FREE) {
+            changed.wait(l);
+        }
+        return b;
+    }
+    void submit(block &b) {
+        std::lock_guard<std::mutex> l(lock);
+        b.state = BLOCK_READ;
+        nread++;
+        changed.notify_all();
+    }
+    void finish() {
+        {
+            std::lock_guard<std::mutex> l(lock);
+            done = true;
+            changed.notify_all();
+        }
+        for (size_t i = 0; i < threads.size(); i++) {
+            threads[i].join();
+        }
+    }
+};
+
+static void strip_mapped(const char *p, const char *end, int nworkers) {
+    strip_pipeline pipeline(nworkers);
+    while (p < end) {
+        const char *cut = end;
+        if ((size_t)(end - p) > block_size) {
+            const char *nl = (const char *)memchr(p + block_size, '\n', end - p - block_size);
+            cut = (nl == NULL) ? end : nl + 1;
+        }
+        block &b = pipeline.next();
+        b.begin = p;
+        b.end = cut;
+        b.eof = cut == end;
+        pipeline.submit(b);
+        p = cut;
+    }
+    pipeline.finish();
+}
+
+// read blocks ending at a newline, carrying the incomplete last line
+// over to the next block
+static bool strip_stream(int fd, int nworkers) {
+    strip_pipeline pipeline(nworkers);
+    std::vector<char> carry;
+    bool eof = false, ok = true;
+    while (!eof) {
+        block &b = pipeline.next();
+        b.data.swap(carry);
+        size_t have = b.data.size();
+        b.data.resize(have >= block_size ? 2 * have : block_size);
+        size_t cut = 0;
+        while (cut == 0 && !eof) {
+            ssize_t n = read(fd, b.data.data() + have, b.data.size() - have);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                ok = n == 0;
+                eof = true;
                 break;
             }
-    	}
-    	std::cout << line.substr(c) << std::endl;
-    	c = 0;
+            have += n;
+            if (have == b.data.size()) {
+                const char *nl = (const char *)memrchr(b.data.data(), '\n', have);
+                if (nl == NULL) {
+                    b.data.resize(2 * have);
+                } else {
+                    cut = nl + 1 - b.data.data();
+                }
+            }
+        }
+        if (eof) {
+            cut = have;
+        }
+        carry.assign(b.data.begin() + cut, b.data.begin() + have);
+        b.begin = b.data.data();
+        b.end = b.begin + cut;
+        b.eof = eof;
+        pipeline.submit(b);
+    }
+    pipeline.finish();
+    return ok;
+}
+
+int main(int argc, char **argv) {
+    int nworkers = 1;
+    if (argc == 3 && strcmp(argv[1], "-j") == 0) {
+        nworkers = atoi(argv[2]);
+        if (nworkers <= 0) {
+            nworkers = std::thread::hardware_concurrency();
+        }
+    } else if (argc != 1) {
+        fputs("usage: rmprefix [-j threads]\n", stderr);
+        exit(EXIT_FAILURE);
+    }
+
+    ranges_writer out(STDOUT_FILENO);
+    struct stat st;
+    if (fstat(STDIN_FILENO, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        void *m = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, STDIN_FILENO, 0);
+        if (m != MAP_FAILED) {
+            madvise(m, st.st_size, MADV_SEQUENTIAL);
+            if (nworkers > 1) {
+                strip_mapped((const char *)m, (const char *)m + st.st_size, nworkers);
+            } else {
+                strip_lines((const char *)m, (const char *)m + st.st_size, true, out);
+                out.flush();
+            }
+            exit(EXIT_SUCCESS);
+        }
+    }
+    if (nworkers > 1) {
+        exit(strip_stream(STDIN_FILENO, nworkers) ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+
+    // not a regular file: read into a buffer that keeps the incomplete
+    // last line for the next read and grows only for very long lines
+    std::vector<char> buf(1 << 20);
+    size_t have = 0;
+    for (;;) {
+        ssize_t n = read(STDIN_FILENO, buf.data() + have, buf.size() - have);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            exit(EXIT_FAILURE);
+        }
+        have += n;
+        const char *rest = strip_lines(buf.data(), buf.data() + have, n == 0, out);
+        out.flush();
+        if (n == 0) {
+            break;
+        }
+        have = buf.data() + have - rest;
+        memmove(buf.data(), rest, have);
+        if (have == buf.size()) {
+            buf.resize(2 * buf.size());
+        }
     }
-	exit(EXIT_SUCCESS);
+    exit(EXIT_SUCCESS);
 }
@@ -7,14 +7,38 @@ Then run:
 
 This will create a file `output.zip`.
 
+To run the testcases on 8 cores at once, run:
+
+    python zipout.py -j 8
+
+To write the time each testcase took to `timing.txt`, slowest first, run:
+
+    python zipout.py --timing timing.txt
+
 To customize the files used by default, run:
 
     python zipout.py -h
 """
 
-import sys, os, optparse, logging, tempfile, subprocess, shutil
+import sys, os, optparse, logging, tempfile, subprocess, shutil, time, zipfile
+import concurrent.futures
 import iocollect
 
+def make_zipfile(base_name, root_dir):
+    """
+    Same as shutil.make_archive(base_name, 'zip', root_dir) but with the
+    entries sorted, so the zip does not depend on the order in which
+    the output files were created.
+    """
+    zip_path = base_name + '.zip'
+    with zipfile.ZipFile(zip_path, 'w', zipfile.ZIP_DEFLATED) as zf:
+        for (dirpath, dirnames, filenames) in os.walk(root_dir):
+            dirnames.sort()
+            for name in dirnames + sorted(filenames):
+                path = os.path.join(dirpath, name)
+                zf.write(path, os.path.relpath(path, root_dir))
+    return os.path.abspath(zip_path)
+
 class ZipOutput:
 
     def __init__(self, opts):
@@ -26,6 +50,8 @@ class ZipOutput:
         self.testcase_dir = opts.testcase_dir # directory where testcases are placed
         self.output_dir = opts.output_dir # directory for output files of your program
         self.file_suffix = opts.file_suffix # file suffix for testcases
+        self.jobs = opts.jobs or os.cpu_count() # number of testcases to run at the same time
+        self.timing_file = opts.timing_file # where to write the time taken by each testcase
 
     def mkdirp(self, path):
         try:
@@ -101,6 +127,9 @@ class ZipOutput:
                 os.remove(stderr_path)
 
     def run_path(self, path, files):
+        """
+        Returns the arguments to run() for each testcase in path.
+        """
         print("running on {} files".format(path), file=sys.stderr)
         # set up output directory
         if path is None or path == '':
@@ -108,6 +137,7 @@ class ZipOutput:
         else:
             output_path = os.path.abspath(os.path.join(self.output_dir, path))
         self.mkdirp(output_path)
+        tests = []
         for filename in files:
             if path is None or path == '':
                 testfile_path = os.path.abspath(os.path.join(self.testcase_dir, filename))
@@ -116,7 +146,33 @@ class ZipOutput:
             if filename[-len(self.file_suffix):] == self.file_suffix:
                 base = filename[:-len(self.file_suffix)]
                 if os.path.exists(testfile_path):
-                    self.run(testfile_path, path, output_path, base)
+                    tests.append((testfile_path, path, output_path, base))
+        return tests
+
+    def timed_run(self, test):
+        start = time.monotonic()
+        self.run(*test)
+        return time.monotonic() - start
+
+    def run_tests(self, tests):
+        """
+        Runs the testcases, self.jobs at a time. Every testcase writes
+        its own output files, so the output does not depend on the order
+        in which they finish.
+        """
+        start = time.monotonic()
+        if self.jobs > 1:
+            # each thread only waits on its testcase's subprocess
+            with concurrent.futures.ThreadPoolExecutor(max_workers=self.jobs) as pool:
+                times = list(pool.map(self.timed_run, tests))
+        else:
+            times = [self.timed_run(test) for test in tests]
+        elapsed = time.monotonic() - start
+        if self.timing_file is not None:
+            with open(self.timing_file, 'w') as timing:
+                print("# {} testcases, {} at a time: {:.3f}s wall time, {:.3f}s total".format(len(tests), self.jobs, elapsed, sum(times)), file=timing)
+                for (seconds, test) in sorted(zip(times, tests), key=lambda x: -x[0]):
+                    print("{:.3f}\t{}".format(seconds, os.path.join(test[1] or '', test[3])), file=timing)
 
     def run_all(self):
         # check that a compiled binary exists to run on the testcases
@@ -129,13 +185,15 @@ class ZipOutput:
         # check if testcases has subdirectories
         testcase_subdirs = iocollect.getdirs(os.path.abspath(self.testcase_dir))
 
+        tests = []
         if len(testcase_subdirs) > 0:
             for subdir in testcase_subdirs:
                 files = iocollect.getfiles(os.path.abspath(os.path.join(self.testcase_dir, subdir)))
-                self.run_path(subdir, files)
+                tests += self.run_path(subdir, files)
         else:
             files = iocollect.getfiles(os.path.abspath(self.testcase_dir))
-            self.run_path(None, files)
+            tests += self.run_path(None, files)
+        self.run_tests(tests)
 
         return True
 
@@ -151,6 +209,8 @@ if __name__ == '__main__':
     optparser.add_option("-e", "--ending", dest="file_suffix", default='.txt', help="suffix to use for testcases [default: .txt]")
     optparser.add_option("-o", "--output", dest="output_dir", default='output', help="Save the output from the testcases to this directory.")
     optparser.add_option("-z", "--zipfile", dest="zipfile", default='output', help="zip file with your output answers")
+    optparser.add_option("-j", "--jobs", dest="jobs", type="int", default=1, help="run this many testcases at the same time, 0 for one per core [default: 1]")
+    optparser.add_option("--timing", dest="timing_file", default=None, help="write the time taken by each testcase to this file")
     optparser.add_option("-l", "--logfile", dest="logfile", default=None, help="log file for debugging")
     (opts, _) = optparser.parse_args()
 
@@ -159,7 +219,7 @@ if __name__ == '__main__':
 
     zo = ZipOutput(opts)
     if zo.run_all():
-        outputs_zipfile = shutil.make_archive(opts.zipfile, 'zip', opts.output_dir)
+        outputs_zipfile = make_zipfile(opts.zipfile, opts.output_dir)
         print("{} created".format(outputs_zipfile), file=sys.stderr)
     else:
         logging.error("problem in creating output zip file")